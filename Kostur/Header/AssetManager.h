@@ -0,0 +1,120 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Process-wide cache for everything loaded from disk: textures, shaders and imported models.
+//
+// An asset is looked up first by its key (canonical path plus load options), then by the
+// hash of its file contents, so the same image reached through two different paths (or
+// copied into two model folders) is decoded and uploaded once. Callers hold AssetHandles;
+// the last handle going away doesn't free the asset, it stays cached until the tracked
+// memory (ResourceRegistry) goes over the budget, at which point unreferenced assets are
+// unloaded, least recently used first.
+//
+// Main thread only: loaders create GL objects. The exceptions are decodeTexture, hashFiles,
+// hashBytes and canonicalAssetPath, which loader threads use to prepare work for it.
+
+enum class AssetKind {
+    Texture,
+    Shader,
+    Model
+};
+
+// what a loader produced; unload is called exactly once when the asset is evicted
+struct AssetData {
+    unsigned int glName = 0;        // texture or program name, 0 for CPU-side objects
+    std::shared_ptr<void> object;   // Shader, Model, ...
+    size_t bytes = 0;               // for reporting only, the budget is checked against the registry
+    std::function<void()> unload;
+};
+
+// reference-counted reference to a cached asset; copying adds a reference
+class AssetHandle {
+public:
+    AssetHandle() : slot(-1) {}
+    explicit AssetHandle(int slot);
+    AssetHandle(const AssetHandle& other);
+    AssetHandle& operator=(const AssetHandle& other);
+    ~AssetHandle();
+
+    bool valid() const { return slot >= 0; }
+    unsigned int id() const;
+    void reset();
+
+    template<typename T>
+    T* get() const { return static_cast<T*>(object()); }
+
+private:
+    int slot;
+    void* object() const;
+};
+
+// how an image file becomes a texture; part of the cache key
+enum class TextureVariant {
+    Mipmapped,  // forced to RGB, full mip chain, repeat (model and scene textures)
+    Flipped     // native channel count, flipped vertically, no mips (images drawn as they are, e.g. sprites)
+};
+
+// downsampleTo > 0 box-filters the decoded image down to 1/2, 1/4 or 1/8 of its size, the strongest that keeps
+// the longer side at least downsampleTo (for images drawn much smaller than they are). The file is still decoded
+// at full size first, so this saves upload time and GPU memory, not decode time or peak RAM. Part of the cache key
+AssetHandle acquireTexture(const std::string& path, TextureVariant variant = TextureVariant::Mipmapped, const std::string& owner = "Scene",
+                           int downsampleTo = 0);
+
+// returns at once with a low-resolution preview (the asset pack's, else one gray texel) and decodes the
+// image on a loader thread; the result replaces the preview in place, under the same GL name
+AssetHandle acquireTextureProgressive(const std::string& path, TextureVariant variant = TextureVariant::Mipmapped, const std::string& owner = "Scene",
+                                      int downsampleTo = 0);
+
+// an image read, hashed and decoded off the main thread, waiting for upload
+struct DecodedTexture {
+    std::string path;           // canonical
+    uint64_t contentHash = 0;   // of the file, combined with the variant
+    int width = 0, height = 0, channels = 0;
+    std::vector<unsigned char> pixels;
+    std::string error;          // why decoding failed, for the caller to print from the main thread
+};
+
+// any thread; false (and image.error set) if the file can't be read or decoded. prints nothing
+bool decodeTexture(const std::string& path, TextureVariant variant, DecodedTexture& image, int downsampleTo = 0);
+// uploads the pixels unless the same path or content is already cached
+AssetHandle acquireTexture(const DecodedTexture& image, TextureVariant variant, const std::string& owner = "Scene", int downsampleTo = 0);
+
+// previews stored in the asset pack under "<path>#preview": the image box-filtered to at most this many pixels per side
+#define TEXTURE_PREVIEW_SIZE 64
+bool encodeTexturePreview(const std::string& path, std::vector<unsigned char>& bytes);
+// defines specialize the program (see Shader); each distinct list is its own asset
+AssetHandle acquireShader(const std::string& vertexPath, const std::string& fragmentPath,
+                          const std::vector<std::string>& defines = std::vector<std::string>());
+
+// hot reload: starts recompiling every cached shader that uses one of the files, includes
+// too (canonical paths). The old programs stay current until pollShaderReloads, called between frames,
+// swaps in the ones that finished and linked. returns how many reloads started
+size_t reloadShaders(const std::vector<std::string>& changedFiles);
+void pollShaderReloads();
+
+// generic entry point; load only runs on a miss. contentHash 0 disables sharing by content
+AssetHandle acquireAsset(AssetKind kind, const std::string& key, uint64_t contentHash, const std::function<AssetData()>& load);
+
+std::string canonicalAssetPath(const std::string& path);
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+uint64_t hashFiles(const std::vector<std::string>& paths);     // 0 if any file can't be read
+
+// unloads every asset nobody holds a handle to (shutdown, or a manual purge)
+void purgeUnreferencedAssets();
+
+struct AssetStats {
+    size_t loaded = 0;          // assets currently cached
+    size_t referenced = 0;      // of those, assets with at least one handle
+    size_t bytes = 0;
+    size_t keyHits = 0;         // acquires served by path
+    size_t contentHits = 0;     // acquires served by content hash under a different path
+    size_t loads = 0;
+    size_t evictions = 0;
+    size_t refinements = 0;     // progressive textures whose full decode replaced the preview
+};
+AssetStats assetStats();
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// One read-only archive holding Resources/ and Shaders/, so startup opens a single file
+// instead of dozens. The archive is memory-mapped; stored entries are handed out as views
+// straight into the mapping (no open, read or copy per file), LZ4-compressed entries are
+// decompressed into a buffer owned by the view.
+//
+// Layout (little endian, every offset a multiple of ASSET_PACK_ALIGNMENT):
+//   AssetPackHeader | entry data ... | AssetPackEntry[entryCount], sorted by path | path bytes
+//
+// Paths are looked up by canonicalAssetPath. Anything not in the pack (or every file, when
+// no pack is open) is read from disk, so a stale or missing pack never breaks loading.
+// openAssetPack/closeAssetPack belong to the main thread while no loader runs; readAsset
+// is safe from any thread.
+
+#define ASSET_PACK_ALIGNMENT 16
+
+struct AssetView {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;    // points into the pack; valid until closeAssetPack
+    std::shared_ptr<std::vector<unsigned char>> owned;  // loose file or decompressed entry
+
+    bool valid() const { return data != nullptr; }
+    const char* chars() const { return (const char*)data; }
+};
+
+bool openAssetPack(const std::string& path);   // false (silently) if there's no such file
+void closeAssetPack();
+bool isAssetPackOpen();
+
+// the pack entry if there is one, else the loose file. false if neither exists
+bool readAsset(const std::string& path, AssetView& view);
+// always the file on disk, even when the pack has the path (hot reload of edited files)
+bool readLooseAsset(const std::string& path, AssetView& view);
+bool assetExists(const std::string& path);
+
+// bundles every file under the roots, plus a "#preview" of every image (acquireTextureProgressive);
+// entries that shrink by at least 1/8 are stored LZ4-compressed
+bool buildAssetPack(const std::string& outputPath, const std::vector<std::string>& roots, bool compress = true);
+
+struct AssetPackStats {
+    size_t entries = 0;
+    size_t mappedBytes = 0;
+    size_t views = 0;               // reads served without a copy
+    size_t decompressions = 0;
+    size_t decompressedBytes = 0;
+    size_t looseReads = 0;          // reads that went to the file system
+};
+AssetPackStats assetPackStats();
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+// Worker threads for loading work that doesn't touch GL (file reads, image decoding, model
+// import and mesh processing), and the queue through which they hand GL work back to the
+// main thread. The main loop drains that queue a little every frame, within a time budget,
+// so uploads are spread over frames instead of stalling one.
+//
+// Without startBackgroundLoader() jobs run inline on the calling thread.
+
+void startBackgroundLoader(unsigned int workerCount = 0);  // 0 = one per core, leaving one for the main thread
+void stopBackgroundLoader();                                // finishes running jobs, drops queued ones
+
+void runInBackground(const std::function<void()>& job);
+
+// main-thread step; returning false means it has more to do and runs again on a later call
+void runOnMainThread(const std::function<bool()>& step);
+
+// runs queued main-thread steps in order until budgetMs is used up (at least one step, so
+// loading always progresses). returns how many steps ran
+size_t processMainThreadWork(double budgetMs);
+
+struct BackgroundLoaderStats {
+    size_t workers = 0;
+    size_t queuedJobs = 0;
+    size_t runningJobs = 0;
+    size_t pendingSteps = 0;
+    double lastWorkMs = 0.0;    // main-thread time spent by the last processMainThreadWork
+};
+BackgroundLoaderStats backgroundLoaderStats();
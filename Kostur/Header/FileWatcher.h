@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Watches a directory tree for written, created or renamed files on a background thread:
+// inotify on Linux, ReadDirectoryChangesW on Windows. The main loop collects the changes
+// once per frame; nothing is polled on disk while no file changes.
+//
+// Editors often save in several steps (truncate, write, rename), so one edit can be
+// reported more than once; the set returned by takeChangedFiles has each path only once.
+
+bool startFileWatcher(const std::string& directory);   // false if the directory can't be watched
+void stopFileWatcher();
+
+// canonical paths of the files changed since the last call
+std::vector<std::string> takeChangedFiles();
@@ -0,0 +1,74 @@
+#pragma once
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "VertexFormat.h"
+
+// Shared geometry arena: one large vertex buffer and one large index buffer per vertex
+// format, with a single VAO. Meshes get a sub-range and draw with a base vertex, so
+// every mesh of the same format can be drawn without rebinding and merged into
+// glMultiDrawElementsBaseVertex calls. Freed ranges go back to a first-fit free list
+// (neighbours are coalesced); when nothing fits, the buffers grow by copying on the GPU.
+// A pool has one index type, so 16- and 32-bit meshes of the same format use separate pools.
+
+struct GeometryRange {
+    GLint   baseVertex = 0;   // first vertex in the pool; indices stay relative to it
+    GLsizei vertexCount = 0;
+    GLsizei firstIndex = 0;   // first index in the pool's index buffer
+    GLsizei indexCount = 0;
+
+    bool valid() const { return vertexCount > 0; }
+};
+
+struct GeometryPoolStats {
+    size_t vertexCapacity = 0, vertexUsed = 0;
+    size_t indexCapacity = 0, indexUsed = 0;
+    unsigned int allocations = 0;   // live ranges
+    unsigned int freeBlocks = 0;    // vertex + index free list entries, a rough fragmentation measure
+    unsigned int growths = 0;
+};
+
+class GeometryPool {
+public:
+    GeometryPool(const std::string& name, GLsizei vertexStride, const std::vector<VertexAttribute>& attributes, GLenum indexType,
+                 size_t initialVertices = 1 << 16, size_t initialIndices = 1 << 18);
+
+    // copies the data into the pool; indices are of the pool's index type and relative to the first vertex.
+    // returns an invalid range if either count is 0
+    GeometryRange allocate(const void* vertices, size_t vertexCount, const void* indices, size_t indexCount);
+    void release(const GeometryRange& range);
+
+    // GL objects are created on the first allocation, so pools can be declared before a context exists
+    unsigned int vao() const { return VAO; }
+    const GeometryPoolStats& stats() const { return poolStats; }
+    const std::string& name() const { return poolName; }
+    GLenum indexType() const { return poolIndexType; }
+    size_t vertexStride() const { return stride; }
+
+private:
+    struct Block {
+        size_t offset, size;
+    };
+
+    std::string poolName;
+    GLsizei stride;
+    GLenum poolIndexType;
+    size_t indexBytes;
+    std::vector<VertexAttribute> attributes;
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+    std::vector<Block> freeVertices, freeIndices;
+    GeometryPoolStats poolStats;
+
+    void create();
+    void growVertices(size_t minimumFree);
+    void growIndices(size_t minimumFree);
+
+    static bool takeBlock(std::vector<Block>& freeList, size_t size, size_t& offset);
+    static void giveBlock(std::vector<Block>& freeList, size_t offset, size_t size);
+};
+
+// every pool that has been created, for the render stats HUD
+const std::vector<const GeometryPool*>& geometryPools();
@@ -0,0 +1,80 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "AssetManager.h"
+
+// Retained-mode 2D overlay: textured quads and text in screen pixels (origin bottom left),
+// drawn unlit through one trivial shader (Shaders/hud.*) after the scene.
+//
+// Elements are added once and then only updated. The vertex buffer is rebuilt when an update
+// actually changes what is shown (a number is compared at the precision it is printed with),
+// so a frame in which nothing changed costs one draw per texture and no uploads. All text
+// shares the glyph atlas (TextUtil), so it is a single draw however many strings there are.
+// Elements sharing a texture keep the order they were added in; texture batches are drawn in
+// the order of their first element.
+
+struct HudStats {
+    size_t elements = 0;
+    size_t vertices = 0;
+    size_t drawCalls = 0;       // last frame
+    size_t rebuilds = 0;        // since startup
+};
+
+class HudRenderer {
+public:
+    // after initText; the screen size fixes the projection
+    void init(float screenWidth, float screenHeight);
+    void release();
+
+    // handles stay valid until release
+    int addSprite(unsigned int texture, float x, float y, float width, float height, const glm::vec4& color = glm::vec4(1.0f));
+    int addText(const std::string& text, float x, float y, float scale, const glm::vec4& color);
+
+    void setSpriteTexture(int sprite, unsigned int texture);
+    void setText(int text, const std::string& value);
+    // shows prefix followed by value with this many decimals; reformats only when those digits change
+    void setNumber(int text, const std::string& prefix, double value, int decimals);
+
+    void draw();
+    const HudStats& stats() const { return hudStats; }
+
+private:
+    struct Element {
+        bool isText = false;
+        unsigned int texture = 0;
+        float x = 0.0f, y = 0.0f;
+        float width = 0.0f, height = 0.0f;  // sprites
+        float scale = 1.0f;                 // text
+        glm::vec4 color = glm::vec4(1.0f);
+        std::string text;
+        std::string numberPrefix;           // setNumber's last value, as printed
+        long long numberDigits = 0;
+        int numberDecimals = -1;
+    };
+    struct HudVertex {
+        glm::vec2 position;
+        glm::vec2 uv;
+        unsigned char color[4];
+    };
+    struct Batch {
+        unsigned int texture;
+        int first, count;
+    };
+
+    std::vector<Element> elements;
+    std::vector<HudVertex> vertices;
+    std::vector<Batch> batches;
+    bool dirty = true;
+
+    AssetHandle shaderAsset;
+    glm::mat4 projection = glm::mat4(1.0f);
+    unsigned int vao = 0, vbo = 0;
+    size_t vboBytes = 0;
+    HudStats hudStats;
+
+    void rebuild();
+    void appendQuad(float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, const glm::vec4& color);
+};
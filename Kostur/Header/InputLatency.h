@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Input-to-present latency. Every input event is stamped when its callback fires,
+// attached to the first frame that is built after it (the frame that can reflect it)
+// and resolved when that frame is handed to glfwSwapBuffers.
+//
+// Events are numbered in arrival order. When the simulation runs on its own thread the
+// frame passes the newest sequence its snapshot has applied, so an event only counts as
+// consumed once the simulation has actually seen it.
+
+enum class InputEventType {
+    Key,
+    MouseButton
+};
+
+uint64_t onInputEvent(InputEventType type, double timestamp);   // returns the event's sequence (from 1)
+uint64_t latestInputSequence();
+void beginInputFrame(uint64_t appliedSequence = UINT64_MAX);    // call right before the frame consumes input
+void onFramePresented(double timestamp); // call right after glfwSwapBuffers
+
+void resetInputLatency();
+void printInputLatencyReport(const std::string& configuration);
+std::string inputLatencySummary();
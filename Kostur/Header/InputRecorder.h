@@ -0,0 +1,32 @@
+#pragma once
+#include <GLFW/glfw3.h>
+#include <string>
+
+// Deterministic input capture and replay.
+//
+// The log is a flat binary stream: an 8 byte header followed by records, each
+// starting with a one byte tag. A Frame record holds the frame delta, the cursor
+// position and the state of every polled key; the key/mouse events that GLFW
+// delivered during the glfwPollEvents() after that frame follow it. Replay walks
+// the same sequence, so ProcessInput and the callbacks see exactly what they saw
+// while recording, with the recorded deltas as the simulation timestep.
+
+bool startInputRecording(const char* path);
+void stopInputRecording();
+bool isRecordingInput();
+
+void recordFrame(GLFWwindow* window, float deltaTime);
+void recordKeyEvent(int key, int scancode, int action, int mods);
+void recordMouseButtonEvent(int button, int action, int mods, double x, double y);
+
+bool startInputReplay(const char* path);
+bool isReplayingInput();
+bool replayNextFrame(float& outDeltaTime);  // false once the log is exhausted
+void replayPendingEvents(GLFWwindow* window, GLFWkeyfun keyCallback, GLFWmousebuttonfun mouseCallback);
+
+void recordReplayFrameTime(double ms);
+void printReplayReport(const char* benchPath, const std::string& label);
+
+// Drop-in replacements for glfwGetKey/glfwGetCursorPos that read replayed state when replaying
+int inputGetKey(GLFWwindow* window, int key);
+void inputGetCursorPos(GLFWwindow* window, double* xpos, double* ypos);
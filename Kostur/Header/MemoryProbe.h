@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Process-level memory numbers for benchmarks. The allocation counters come from
+// replacing the global operator new in this executable, so they see every C++
+// allocation made by our code and the headers it inlines (std containers, glm,
+// stb), but not malloc calls or allocations inside DLLs such as Assimp.
+//
+// Counting costs two atomic adds per allocation on every thread, so the replacement
+// is only compiled into benchmark builds: define MEMORY_PROBE_COUNT_ALLOCATIONS
+// (C/C++ > Preprocessor, or /D). Other builds report 0 allocations.
+
+bool countingAllocations();
+size_t allocationCount();   // operator new calls since startup
+size_t allocatedBytes();    // bytes requested from operator new since startup
+size_t peakResidentBytes(); // high-water mark of the working set / RSS
+
+// Appends "label,model,ms,allocations,allocated_kb,peak_rss_kb,kept_kb" to the CSV at
+// path and prints the averages of every (label, model) pair found in the file.
+bool appendLoadBenchmark(const char* path, const std::string& label, const std::string& model, double ms,
+                         size_t allocations, size_t bytes, size_t peakRss, size_t keptBytes);
@@ -0,0 +1,69 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cfloat>
+#include <cstddef>
+#include <vector>
+
+// Bounding volume hierarchy over an indexed triangle list, for ray picking.
+//
+// Built top-down with binned SAH (Wald 2007): at every node the triangle centroids are
+// dropped into BVH_SAH_BINS bins per axis and the split with the lowest surface area
+// cost wins, or the node stays a leaf when splitting costs more than testing its
+// triangles. Nodes are 32 bytes in one array, children next to each other; leaves
+// own a run of triangles stored as their three positions, in leaf order, so a pick
+// touches neither the mesh's vertices nor its indices (which are freed after upload).
+//
+// Rays aren't normalized: t is in units of the direction's length, so an object-space
+// ray (inverse model matrix applied to origin and direction) reports the world-space t.
+
+#define BVH_SAH_BINS 16
+#define BVH_MAX_LEAF_TRIANGLES 8
+
+struct RayHit {
+    float t = FLT_MAX;              // only hits closer than this are reported
+    unsigned int mesh = 0;          // set by ModelBvh
+    unsigned int triangle = 0;      // index into the mesh's original triangle list
+    glm::vec2 barycentric = glm::vec2(0.0f);    // weights of the triangle's second and third vertex
+};
+
+class MeshBvh {
+public:
+    // positions are read through a byte stride; triangles are indices[3 * i .. 3 * i + 2]
+    void build(const float* positions, size_t positionStride, const unsigned int* indices, size_t triangleCount);
+
+    // closest hit in front of the origin and nearer than hit.t; hit is only written on success
+    bool intersect(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit) const;
+
+    bool empty() const { return nodes.empty(); }
+    glm::vec3 boundsMin() const { return nodes.empty() ? glm::vec3(0.0f) : nodes[0].boundsMin; }
+    glm::vec3 boundsMax() const { return nodes.empty() ? glm::vec3(0.0f) : nodes[0].boundsMax; }
+    size_t nodeCount() const { return nodes.size(); }
+    size_t triangleCount() const { return triangleIds.size(); }
+    size_t bytes() const;
+
+private:
+    struct Node {
+        glm::vec3 boundsMin;
+        unsigned int first;     // leaf: first triangle; inner: left child (the right one follows it)
+        glm::vec3 boundsMax;
+        unsigned int count;     // triangles in a leaf, 0 for inner nodes
+    };
+
+    std::vector<Node> nodes;
+    std::vector<glm::vec3> corners;         // 3 per triangle, leaf order
+    std::vector<unsigned int> triangleIds;  // leaf order -> original triangle
+};
+
+// one BVH per mesh of a model, with the model's bounds as a first, cheap rejection
+struct ModelBvh {
+    std::vector<MeshBvh> meshes;
+    glm::vec3 boundsMin = glm::vec3(0.0f), boundsMax = glm::vec3(0.0f);
+
+    bool intersect(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit) const;
+    size_t bytes() const;
+};
+
+// entry distance of the ray into the box, or false if it misses it or enters beyond maxT
+bool intersectRayBox(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& boxMin, const glm::vec3& boxMax,
+                     float maxT, float& entryT);
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Load-time triangle and vertex reordering for indexed triangle lists.
+//
+//   1. optimizeVertexCache  - Tipsify (Sander, Nehab, Barczak 2007): fans around
+//                             cached vertices so the post-transform cache hits more often
+//   2. optimizeOverdraw     - splits the result where the cache starts cold anyway and
+//                             sorts those clusters outside-in, so occluders draw first
+//   3. optimizeVertexFetch  - renumbers vertices in first-use order for linear fetches
+//
+// All functions work on indices only; positions are read through a byte stride and
+// vertex data is permuted by the caller from the returned remap.
+
+struct VertexCacheStats {
+    float acmr = 0.0f;   // average cache miss ratio: transformed vertices per triangle (0.5 ideal, 3 worst)
+    float atvr = 0.0f;   // average transform to vertex ratio: transformed / referenced vertices (1 ideal)
+};
+
+// simulates a FIFO post-transform cache of the given size
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = 16);
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = 16);
+
+// keeps the cache order if sorting would raise ACMR by more than the threshold factor
+void optimizeOverdraw(std::vector<unsigned int>& indices, const float* positions, size_t positionStride, size_t vertexCount,
+                      float threshold = 1.05f, unsigned int cacheSize = 16);
+
+// rewrites indices in first-use order; returns the old index of every new vertex (unreferenced vertices are dropped)
+std::vector<unsigned int> optimizeVertexFetch(std::vector<unsigned int>& indices, size_t vertexCount);
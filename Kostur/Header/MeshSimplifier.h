@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Quadric error edge collapse (Garland & Heckbert 1997) on an indexed triangle list.
+// Collapses move vertices onto existing neighbours, so the simplified indices still
+// reference the original vertex buffer and LODs can share it.
+//
+// Vertices are welded by position into groups that always move together, so a normal
+// crease (same position and UV, different normals) collapses like any other vertex
+// without opening a crack. A group is locked, never moved, when its members disagree on
+// UV (a texture seam) or material (a boundary inside a packed mesh), or when it lies on
+// an open border; seams and boundaries stay where they were.
+
+// returns the simplified indices, at or above targetIndexCount if collapses within maxError run out.
+// resultError receives the largest collapse error, as an object-space distance.
+// uvs (two floats per vertex) and materials (one id per vertex) are optional; without them
+// members of a group are assumed to agree.
+std::vector<unsigned int> simplifyMesh(const std::vector<unsigned int>& indices, const float* positions, size_t positionStride,
+                                       size_t vertexCount, size_t targetIndexCount, float maxError, float* resultError,
+                                       const float* uvs = nullptr, size_t uvStride = 0, const unsigned int* materials = nullptr);
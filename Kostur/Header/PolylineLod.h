@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Multiresolution polyline: the Douglas-Peucker split tree of a point list, with every split's
+// error (the distance of its vertex from the chord it splits) raised to the largest error under
+// it and a bounding box of its range. Selecting at a view walks the tree from the root and stops
+// wherever the projected error drops below the pixel threshold; since neither a larger error nor
+// a nearer box can be found below a node, everything skipped would have been skipped anyway.
+// The result is a subsequence of the points (the endpoints always included).
+//
+// Selection is incremental: each walk also records how far the viewer can move before any node
+// it looked at crosses the threshold (distances to a box change no faster than the viewer
+// moves). Until the viewer leaves that radius, select() returns at once and keeps the points.
+
+struct PolylineLodStats {
+    size_t points = 0;
+    size_t nodes = 0;
+    size_t selected = 0;
+    size_t walks = 0;           // selections that walked the tree
+    size_t reuses = 0;          // selections answered by the previous walk
+};
+
+class PolylineLod {
+public:
+    void build(const std::vector<glm::vec3>& points);
+
+    // pixelScale as in LodContext; returns true if the selected points changed
+    bool select(const glm::vec3& viewPos, float pixelScale, float maxPixelError);
+
+    const std::vector<glm::vec3>& selectedPoints() const { return selected; }
+    // changes whenever selectedPoints does (PolylineRenderer::setPoints)
+    uint64_t revision() const { return selectionRevision; }
+    const PolylineLodStats& stats() const { return lodStats; }
+
+private:
+    struct Node {
+        uint32_t first, last, split;    // the split vertex lies strictly between first and last
+        int32_t left, right;            // child nodes for (first, split) and (split, last), -1 if none
+        float error;                    // largest split error in this subtree
+        glm::vec3 boundsMin, boundsMax; // of points first..last
+    };
+
+    std::vector<glm::vec3> points;
+    std::vector<Node> nodes;            // nodes[0] is the root; parents before their children
+    std::vector<glm::vec3> selected;
+    uint64_t selectionRevision = 0;
+    PolylineLodStats lodStats;
+
+    // the last walk's view and how far it may move before the selection could change
+    bool walked = false;
+    glm::vec3 walkViewPos = glm::vec3(0.0f);
+    float walkThreshold = 0.0f;         // maxPixelError / pixelScale
+    float walkSlack = 0.0f;
+
+    int32_t addNode(uint32_t first, uint32_t last);
+    void walk(const glm::vec3& viewPos, float threshold, std::vector<uint32_t>& indices, float& slack) const;
+};
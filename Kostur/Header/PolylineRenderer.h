@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "AssetManager.h"
+
+// Thick world-space polylines (the measurement route) with a constant width in pixels.
+//
+// The points live in one vertex buffer that is bound twice, the second time one point
+// further, so instance i of a four-vertex strip sees points i and i+1. Shaders/polyline.vert
+// projects both, clips them to the near plane and expands the segment into a screen-space
+// quad half a width wider on every side; polyline.frag fades coverage by the pixel's distance
+// to the segment. The caps come out round, so consecutive segments join round, and the edge
+// is anti-aliased over one pixel without MSAA or glLineWidth (which core profiles clamp).
+// A whole route is one draw; the buffer is written only when the points change.
+
+struct PolylineStats {
+    size_t segments = 0;
+    size_t uploads = 0;         // since startup
+    size_t uploadedBytes = 0;
+};
+
+class PolylineRenderer {
+public:
+    void init();
+    void release();
+
+    // revision identifies the contents (SimState::measurementRevision); the same revision twice uploads nothing
+    void setPoints(const std::vector<glm::vec3>& points, uint64_t revision);
+
+    // blended over the opaque scene, depth tested but not written. viewport is the current
+    // glViewport (x, y, width, height), in the framebuffer pixels gl_FragCoord counts
+    void draw(const glm::mat4& viewProjection, const glm::vec4& viewport, float widthPixels, const glm::vec4& color);
+
+    const PolylineStats& stats() const { return polylineStats; }
+
+private:
+    AssetHandle shaderAsset;
+    unsigned int vao = 0, vbo = 0;
+    size_t capacity = 0;        // points the buffer holds
+    size_t pointCount = 0;
+    uint64_t revision = UINT64_MAX;
+    PolylineStats polylineStats;
+};
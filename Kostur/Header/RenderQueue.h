@@ -0,0 +1,105 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "shader.hpp"
+#include "material.hpp"
+#include "ShaderVariants.h"
+#include "VertexFormat.h"
+
+// Deferred draw submission. Draws are recorded as packets with a 64-bit sort key
+// and executed in key order on flush(), skipping program/texture/VAO/material
+// binds that the previous packet already left in place. Consecutive indexed
+// packets that share program, material, VAO and model matrix (meshes of one
+// model in a GeometryPool) are merged into one glMultiDrawElementsBaseVertex.
+// Normal matrices for every packet are computed in one pass before drawing and
+// set as uN next to uM, so shaders never invert a matrix.
+//
+// Draws submitted with a ShaderVariants set get the variant for their material's
+// features plus the pass's (setPassFeatures: lighting), so every draw runs the
+// cheapest program that shades it and variants sort like separate programs.
+//
+// Key layout (most significant first):
+//   pass (4) | program (8) | material (12) | vao (16) | depth (24)
+
+// blended and 2D geometry is drawn after flush (PolylineRenderer, HudRenderer)
+enum class RenderPass : uint8_t {
+    Opaque = 0,
+    Count
+};
+
+struct DrawPacket {
+    uint64_t key;
+    Shader* shader;
+    unsigned int vao;
+    const Material* material;
+    GLenum mode;
+    GLsizei count;
+    GLint first;        // first vertex, or first index when indexed
+    GLint baseVertex;
+    GLenum indexType;
+    bool indexed;
+    float lineWidth;
+    glm::mat4 model;
+};
+
+struct RenderQueueStats {
+    unsigned int packets = 0;
+    unsigned int programBinds = 0, programBindsSaved = 0;
+    unsigned int textureBinds = 0, textureBindsSaved = 0;
+    unsigned int vaoBinds = 0, vaoBindsSaved = 0;
+    unsigned int materialBinds = 0, materialBindsSaved = 0;
+    unsigned int drawCalls = 0, mergedDraws = 0;
+    unsigned int triangles = 0;     // GL_TRIANGLES draws only
+    unsigned int uniformScaleNormals = 0, generalNormals = 0;
+};
+
+class RenderQueue {
+public:
+    // Called whenever a program becomes current within a pass, to set per-pass uniforms (camera, lights...)
+    typedef std::function<void(Shader&)> PassSetup;
+
+    void begin(const glm::vec3& viewPos, float farPlane);
+    void setPassSetup(RenderPass pass, PassSetup setup);
+    // variant keys added to every ShaderVariants draw of the pass
+    void setPassFeatures(RenderPass pass, unsigned int features);
+
+    void submitArrays(RenderPass pass, Shader& shader, unsigned int vao, GLenum mode, GLint first, GLsizei count,
+                      const glm::mat4& model, const Material& material, float lineWidth = 1.0f);
+    void submitElements(RenderPass pass, Shader& shader, unsigned int vao, GLsizei indexCount,
+                        const glm::mat4& model, const Material& material, GLint firstIndex = 0, GLint baseVertex = 0,
+                        GLenum indexType = GL_UNSIGNED_INT);
+    void submitArrays(RenderPass pass, ShaderVariants& shaders, unsigned int vao, GLenum mode, GLint first, GLsizei count,
+                      const glm::mat4& model, const Material& material, float lineWidth = 1.0f);
+    void submitElements(RenderPass pass, ShaderVariants& shaders, unsigned int vao, GLsizei indexCount,
+                        const glm::mat4& model, const Material& material, GLint firstIndex = 0, GLint baseVertex = 0,
+                        GLenum indexType = GL_UNSIGNED_INT);
+
+    void flush();
+
+    const RenderQueueStats& stats() const { return lastStats; }
+
+private:
+    std::vector<DrawPacket> packets;
+    std::vector<unsigned int> programSlots;
+    std::vector<unsigned int> vaoSlots;
+    PassSetup passSetups[(int)RenderPass::Count];
+    unsigned int passFeatures[(int)RenderPass::Count] = {};
+    glm::vec3 viewPos = glm::vec3(0.0f);
+    float farPlane = 100.0f;
+    RenderQueueStats lastStats;
+    std::vector<GLsizei> multiCounts;
+    std::vector<const void*> multiOffsets;
+    std::vector<GLint> multiBaseVertices;
+    std::vector<glm::mat3> normalMatrices;
+
+    void submit(RenderPass pass, Shader& shader, unsigned int vao, GLenum mode, GLint first, GLint baseVertex, GLsizei count, bool indexed,
+                GLenum indexType, const glm::mat4& model, const Material& material, float lineWidth);
+    static bool canMerge(const DrawPacket& a, const DrawPacket& b);
+    void computeNormalMatrices(RenderQueueStats& stats);
+    static unsigned int slotFor(std::vector<unsigned int>& slots, unsigned int id);
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Bookkeeping for every GL object (and CPU-side copy) the application creates.
+// Sizes are estimates: the driver may pad or compress, but the totals are close
+// enough to see which assets dominate and when we cross the budget.
+
+enum class ResourceKind {
+    Texture,
+    Buffer,
+    VertexArray,
+    CpuData
+};
+
+struct ResourceInfo {
+    ResourceKind kind;
+    unsigned int id;
+    size_t       bytes;
+    std::string  owner;   // subsystem that created it (Model, Scene, Text...)
+    std::string  origin;  // file it was loaded from, empty for generated data
+};
+
+void trackResource(ResourceKind kind, unsigned int id, size_t bytes, const std::string& owner, const std::string& origin = "");
+void untrackResource(ResourceKind kind, unsigned int id);
+
+size_t estimateTextureBytes(int width, int height, int channels, bool mipmapped);
+
+size_t trackedBytes();
+size_t trackedBytes(ResourceKind kind);
+size_t trackedCount(ResourceKind kind);
+const std::vector<ResourceInfo>& trackedResources();
+
+// A warning is printed once every time the tracked total rises above the budget (0 = no budget).
+void setMemoryBudget(size_t bytes);
+size_t memoryBudget();
+
+bool dumpResourcesJson(const char* path);
+std::vector<std::string> resourceSummaryLines(size_t maxEntries);
+const char* resourceKindName(ResourceKind kind);
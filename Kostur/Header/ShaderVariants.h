@@ -0,0 +1,44 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AssetManager.h"
+#include "shader.hpp"
+
+// Specialized programs compiled from one vertex/fragment pair. A variant key is a bit
+// mask; bit i set means featureNames[i] is #defined (see Shader). Variants compile the
+// first time a draw asks for them and are cached in the asset manager, so hot reload
+// and eviction treat each one like any other shader.
+//
+// Keys stay a handful in practice (a scene uses few material/light combinations),
+// but nothing stops 2^features of them; prewarm the common ones to keep compiles off
+// the first frames that need them.
+
+class ShaderVariants {
+public:
+    // runs on every variant when it is compiled and after every reload (block bindings, sampler units)
+    std::function<void(Shader&)> programSetup;
+
+    ShaderVariants() {}
+    ShaderVariants(const std::string& vertexPath, const std::string& fragmentPath, const std::vector<std::string>& featureNames);
+
+    // the program for exactly these features, compiled now if it hasn't been
+    Shader& select(unsigned int features);
+    void prewarm(const std::vector<unsigned int>& keys);
+
+    size_t compiledCount() const { return variants.size(); }
+    std::vector<std::string> definesFor(unsigned int features) const;
+
+    // drops every variant's handle (the asset manager unloads them once unreferenced)
+    void clear();
+
+private:
+    std::string vertexPath, fragmentPath;
+    std::vector<std::string> featureNames;
+    std::unordered_map<unsigned int, AssetHandle> variants;
+    // consecutive draws mostly share a variant; skips the hash lookup for them
+    unsigned int lastFeatures = 0;
+    Shader* lastShader = nullptr;
+};
@@ -0,0 +1,169 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "SpscQueue.h"
+
+struct ModelBvh;
+
+// Game logic (player movement, camera, mode switching, measurement edits), kept apart
+// from rendering. The main thread turns GLFW input into SimEvents and pushes them into a
+// lock-free queue; the simulation drains it, advances the world and publishes an
+// immutable SimState snapshot. The renderer only ever reads the latest snapshot, so a
+// slow frame doesn't hold up input handling and a busy simulation doesn't stall a frame.
+//
+// The world advances in fixed ticks (SimConfig::tickRate); step() only feeds elapsed
+// time into an accumulator, so results don't depend on how often it is called. The
+// renderer blends positions between the last two ticks (interpolation()), which costs one
+// tick of display latency but keeps motion smooth at any render rate.
+//
+// Normally the simulation runs on its own thread (start()). During input replay it is
+// stepped from the main loop with the recorded deltas instead, to stay deterministic.
+
+// held keys, sampled by the main thread every frame
+enum SimHeldKey : uint16_t {
+    SimKeyWalkForward  = 1 << 0,    // W
+    SimKeyWalkBack     = 1 << 1,    // S
+    SimKeyWalkLeft     = 1 << 2,    // A
+    SimKeyWalkRight    = 1 << 3,    // D
+    SimKeyCameraUp     = 1 << 4,    // arrows
+    SimKeyCameraDown   = 1 << 5,
+    SimKeyCameraLeft   = 1 << 6,
+    SimKeyCameraRight  = 1 << 7
+};
+
+enum class SimEventType : uint8_t {
+    HeldKeys,       // also sent when only the input sequence moved on, to acknowledge it
+    ToggleMode,
+    Click           // left click at (x, y) in window coordinates
+};
+
+struct SimEvent {
+    SimEventType type;
+    uint16_t heldKeys;
+    double x, y;
+    uint64_t sequence;  // input latency sequence of the newest event this one carries (see InputLatency.h)
+};
+
+// what a click ray hit first; the ground is only reported when no model was in the way
+enum class SimEntity : uint8_t {
+    None,
+    Ground,
+    Player,
+    Pin
+};
+
+struct SimPick {
+    SimEntity entity = SimEntity::None;
+    unsigned int index = 0;         // measurement point of a pin
+    unsigned int mesh = 0, triangle = 0;
+    glm::vec2 barycentric = glm::vec2(0.0f);
+    glm::vec3 point = glm::vec3(0.0f);
+    double microseconds = 0.0;      // time spent on the query
+};
+
+// model matrices of the simulated entities, shared by rendering and picking
+glm::mat4 playerModelMatrix(const glm::vec3& position, float rotationDegrees);
+glm::mat4 pinModelMatrix(const glm::vec3& point);
+
+// the whole simulated world; snapshots are immutable copies of it
+struct SimState {
+    uint64_t tick = 0;
+    uint64_t appliedSequence = 0;   // newest input sequence reflected in this state
+    float interpolation = 0.0f;     // unsimulated time left in the accumulator, in ticks
+    double publishTime = 0.0;       // Simulation::clock() when this state was published
+
+    bool isWalkingMode = true;
+    glm::vec3 cameraPos = glm::vec3(0.0f, 2.0f, 2.0f);
+    glm::vec3 savedWalkPos = glm::vec3(0.0f, 2.0f, 5.0f);
+    glm::vec3 savedMeasurePos = glm::vec3(0.0f, 10.0f, 10.0f);
+
+    glm::vec3 playerPos = glm::vec3(0.0f);
+    float playerRotation = 180.0f;
+    float totalWalkDistance = 0.0f;
+
+    std::vector<glm::vec3> measurementPoints;
+    uint64_t measurementRevision = 0;   // bumped whenever measurementPoints changes, so renderers upload only then
+    float totalMeasuredLength = 0.0f;
+
+    SimPick lastPick;
+
+    // positions at the previous tick, blended towards the current ones for display
+    glm::vec3 previousCameraPos = cameraPos;
+    glm::vec3 previousPlayerPos = playerPos;
+
+    glm::vec3 displayCameraPos(float alpha) const { return glm::mix(previousCameraPos, cameraPos, alpha); }
+    glm::vec3 displayPlayerPos(float alpha) const { return glm::mix(previousPlayerPos, playerPos, alpha); }
+};
+
+// constants the simulation needs from the application
+struct SimConfig {
+    float tickRate;             // simulation ticks per second
+    float mapSize;
+    float playerSpeed;
+    float cameraSpeed;
+    glm::vec3 cameraFront;
+    unsigned int screenWidth, screenHeight;
+    float fovy;                 // radians
+    float iconSize, iconPadding;
+};
+
+class Simulation {
+public:
+    Simulation();
+    ~Simulation();
+
+    void init(const SimConfig& config, const SimState& initial);
+
+    // runs the simulation on its own thread, waking once per tick with the measured time between steps
+    void start();
+    void stop();
+    bool isThreaded() const { return running.load(); }
+
+    // main thread only; false (and the event is dropped) if the queue is full
+    bool pushEvent(const SimEvent& event);
+
+    // geometry clicks are tested against, once the models are loaded. Until then (or with null)
+    // clicks fall through to the ground plane
+    void setPickShapes(std::shared_ptr<const ModelBvh> player, std::shared_ptr<const ModelBvh> pin);
+
+    // drains queued events, runs as many fixed ticks as dt seconds (plus leftover time) cover
+    // and publishes a snapshot. only for the non-threaded mode; the thread calls it itself
+    void step(float dt);
+
+    std::shared_ptr<const SimState> snapshot() const;
+
+    // blend factor between a snapshot's previous and current tick for a frame drawn now. Threaded,
+    // it includes the time since publishing; stepped from the main loop, it's just the leftover
+    float interpolation(const SimState& snapshot) const;
+
+    static double clock();  // seconds, monotonic
+
+private:
+    SimConfig config;
+    SimState state;
+    uint16_t heldKeys = 0;
+    float accumulator = 0.0f;
+
+    SpscQueue<SimEvent, 1024> events;
+    std::shared_ptr<const SimState> published;  // swapped with std::atomic_store / atomic_load
+    std::shared_ptr<const ModelBvh> playerShape, pinShape;  // likewise
+    std::thread thread;
+    std::atomic<bool> running;
+
+    void run();
+    void apply(const SimEvent& event);
+    void tick(float dt);
+    void publish();
+
+    void toggleMode();
+    void click(double x, double y);
+    void clickRay(double x, double y, glm::vec3& origin, glm::vec3& direction) const;
+    bool groundIntersection(const glm::vec3& origin, const glm::vec3& direction, glm::vec3& hit) const;
+    bool pick(const glm::vec3& origin, const glm::vec3& direction, SimPick& result) const;
+};
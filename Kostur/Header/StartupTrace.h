@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+
+// Wall-clock tracing of the startup sequence. Phases are sequential and
+// non-overlapping (beginning a new phase ends the previous one); asset timings
+// are recorded inside whichever phase is active.
+
+void beginStartupPhase(const std::string& name);
+void endStartupPhase();
+void recordAssetTiming(const std::string& asset, double ms);
+// a named point in time (e.g. first_frame, models_ready), reported next to the phases
+void markStartupMilestone(const std::string& name);
+
+double startupNowMs();      // milliseconds since the trace started
+bool isStartupTracing();    // false once the report was printed
+
+void printStartupReport();
+
+// Appends "label,first_frame_ms,models_ready_ms,phase=ms;..." to the CSV at path
+// and prints the averages of every label found in the file (e.g. cold vs warm
+// runs). A milestone that was never reached is left empty.
+bool appendStartupBenchmark(const char* path, const std::string& label);
+
+// Times the enclosing scope and reports it as an asset load.
+struct ScopedAssetTimer {
+    std::string asset;
+    double start;
+
+    ScopedAssetTimer(const std::string& asset) : asset(asset), start(startupNowMs()) {}
+    ~ScopedAssetTimer() { recordAssetTiming(asset, startupNowMs() - start); }
+};
@@ -1,12 +1,30 @@
 #pragma once
 #include <string>
+#include <vector>
+
+// Glyphs 0-127 of one font, rendered at 48 px and packed into a single atlas texture.
+// The atlas is GL_RED, swizzled to sample as white with the glyph's coverage in alpha,
+// so text can share a shader (and a draw) with ordinary sprites (see HudRenderer).
 
 void initText(unsigned int shaderProgram, const char* fontPath);
+void releaseText();
+// immediate mode, for debug pages: one buffer upload and one draw per call
 void RenderText(unsigned int shader, std::string text, float x, float y, float scale, float r, float g, float b);
 
 struct Character {
-    unsigned int TextureID;
+    unsigned int TextureID;     // the atlas
     int          Size[2];
     int          Bearing[2];
     unsigned int Advance;
+    float        Uv[4];         // u0, v0 (top left), u1, v1 in the atlas
+};
+
+// one glyph's screen rectangle (x, y up) and atlas coordinates
+struct GlyphQuad {
+    float x0, y0, x1, y1;
+    float u0, v0, u1, v1;
 };
+
+// appends the quads of text with its baseline starting at (x, y); returns the pen position after it
+float layoutText(const std::string& text, float x, float y, float scale, std::vector<GlyphQuad>& quads);
+unsigned int textAtlas();
@@ -0,0 +1,141 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// Vertex layouts described at compile time. A layout lists its attributes as
+// VertexAttrib<type, offset, location>; the GL component count, type and
+// normalization come from AttributeTraits of the member type, so quantized
+// members (half floats, 10:10:10:2 normals) set themselves up correctly.
+//
+//   typedef VertexLayout<MyVertex,
+//       VERTEX_ATTRIB(MyVertex, Position, 0),
+//       VERTEX_ATTRIB(MyVertex, Normal, 1)> MyLayout;
+//   MyLayout::apply();   // with the VAO and vertex buffer bound
+
+struct VertexAttribute {
+    GLuint    index;
+    GLint     size;       // number of components
+    GLenum    type;
+    GLboolean normalized;
+    size_t    offset;     // within one vertex
+};
+
+// --- quantized component types ---
+
+// two IEEE half floats, for texture coordinates
+struct Half2 {
+    uint16_t x, y;
+};
+
+// signed normalized 10:10:10:2 (x in the low bits), for unit normals; w is unused
+struct PackedNormal {
+    uint32_t bits;
+};
+
+inline uint16_t toHalf(float value)
+{
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+    uint32_t sign = (x >> 16) & 0x8000;
+    int32_t exponent = (int32_t)((x >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = x & 0x7FFFFF;
+
+    if (exponent <= 0) {
+        // too small for a normal half: subnormal or zero
+        if (exponent < -10) return (uint16_t)sign;
+        mantissa |= 0x800000;
+        uint32_t shift = (uint32_t)(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1) half++;
+        return (uint16_t)(sign | half);
+    }
+    if (exponent >= 31) return (uint16_t)(sign | 0x7C00); // overflow to infinity
+
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000) half++; // round to nearest, a carry correctly bumps the exponent
+    return (uint16_t)half;
+}
+
+inline Half2 toHalf2(const glm::vec2& v)
+{
+    Half2 h;
+    h.x = toHalf(v.x);
+    h.y = toHalf(v.y);
+    return h;
+}
+
+inline PackedNormal packNormal(const glm::vec3& n)
+{
+    const float c[3] = { n.x, n.y, n.z };
+    uint32_t bits = 0;
+    for (int i = 0; i < 3; i++) {
+        float clamped = c[i] < -1.0f ? -1.0f : (c[i] > 1.0f ? 1.0f : c[i]);
+        int32_t q = (int32_t)std::lround(clamped * 511.0f);
+        bits |= ((uint32_t)q & 0x3FF) << (10 * i);
+    }
+    PackedNormal packed;
+    packed.bits = bits;
+    return packed;
+}
+
+// --- attribute traits ---
+
+template<typename T> struct AttributeTraits;
+
+template<> struct AttributeTraits<float>        { enum { components = 1 }; static GLenum type() { return GL_FLOAT; }                 static GLboolean normalized() { return GL_FALSE; } };
+template<> struct AttributeTraits<glm::vec2>    { enum { components = 2 }; static GLenum type() { return GL_FLOAT; }                 static GLboolean normalized() { return GL_FALSE; } };
+template<> struct AttributeTraits<glm::vec3>    { enum { components = 3 }; static GLenum type() { return GL_FLOAT; }                 static GLboolean normalized() { return GL_FALSE; } };
+template<> struct AttributeTraits<glm::vec4>    { enum { components = 4 }; static GLenum type() { return GL_FLOAT; }                 static GLboolean normalized() { return GL_FALSE; } };
+template<> struct AttributeTraits<Half2>        { enum { components = 2 }; static GLenum type() { return GL_HALF_FLOAT; }            static GLboolean normalized() { return GL_FALSE; } };
+template<> struct AttributeTraits<PackedNormal> { enum { components = 4 }; static GLenum type() { return GL_INT_2_10_10_10_REV; }   static GLboolean normalized() { return GL_TRUE; } };
+
+template<typename T, size_t Offset, GLuint Location>
+struct VertexAttrib {
+    static VertexAttribute describe()
+    {
+        VertexAttribute attribute = { Location, AttributeTraits<T>::components, AttributeTraits<T>::type(), AttributeTraits<T>::normalized(), Offset };
+        return attribute;
+    }
+};
+
+#define VERTEX_ATTRIB(VertexType, Member, Location) \
+    VertexAttrib<decltype(std::declval<VertexType>().Member), offsetof(VertexType, Member), Location>
+
+// expects the VAO and the vertex buffer to be bound
+inline void applyVertexAttributes(GLsizei stride, const std::vector<VertexAttribute>& attributes)
+{
+    for (const VertexAttribute& attribute : attributes) {
+        glEnableVertexAttribArray(attribute.index);
+        glVertexAttribPointer(attribute.index, attribute.size, attribute.type, attribute.normalized, stride, (void*)attribute.offset);
+    }
+}
+
+template<typename V, typename... Attribs>
+struct VertexLayout {
+    typedef V VertexType;
+
+    static GLsizei stride() { return (GLsizei)sizeof(V); }
+    static std::vector<VertexAttribute> attributes() { return { Attribs::describe()... }; }
+    static void apply() { applyVertexAttributes(stride(), attributes()); }
+};
+
+// plain position stream (lines, debug geometry)
+typedef VertexLayout<glm::vec3, VertexAttrib<glm::vec3, 0, 0>> PositionLayout;
+
+// --- index types ---
+
+template<typename I> struct IndexTraits;
+template<> struct IndexTraits<uint16_t>     { static GLenum type() { return GL_UNSIGNED_SHORT; } };
+template<> struct IndexTraits<unsigned int> { static GLenum type() { return GL_UNSIGNED_INT; } };
+
+inline size_t indexSize(GLenum indexType)
+{
+    return indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+}
@@ -0,0 +1,169 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "shader.hpp"
+#include "ResourceRegistry.h"
+
+// uniform block binding point and fixed texture units shared by every program that shades materials
+#define MATERIAL_UBO_BINDING 0
+#define MATERIAL_UNIT_DIFFUSE 0
+#define MATERIAL_UNIT_SPECULAR 1
+#define MATERIAL_UNIT_DIFFUSE_ARRAY 2
+#define MATERIAL_UNIT_COUNT 3
+
+// values of MaterialConstants::useDiffuseMap
+#define MATERIAL_DIFFUSE_NONE 0
+#define MATERIAL_DIFFUSE_TEXTURE 1
+#define MATERIAL_DIFFUSE_PACKED 2   // per-vertex tint and layer into a texture array (Model packing)
+
+// variant keys of the material program (bit i = MATERIAL_SHADER_FEATURES[i] is #defined, see ShaderVariants).
+// the maps come from the material, lighting from the pass it's drawn in
+#define MATERIAL_SHADER_DIFFUSE_MAP   (1u << 0)
+#define MATERIAL_SHADER_DIFFUSE_ARRAY (1u << 1)
+#define MATERIAL_SHADER_SPECULAR_MAP  (1u << 2)
+#define MATERIAL_SHADER_LIT           (1u << 3)
+#define MATERIAL_SHADER_LIGHTS_4      (1u << 4)
+#define MATERIAL_SHADER_LIGHTS_16     (1u << 5)
+#define MATERIAL_SHADER_LIGHTS_32     (1u << 6)
+#define MATERIAL_SHADER_FEATURES { "DIFFUSE_MAP", "DIFFUSE_ARRAY", "SPECULAR_MAP", "LIT", "LIGHTS_4", "LIGHTS_16", "LIGHTS_32" }
+
+// the smallest light array that holds this many point lights; 0 lights compiles the loop out
+inline unsigned int MaterialLightFeatures(int pointLights)
+{
+    if (pointLights <= 0)  return 0;
+    if (pointLights <= 4)  return MATERIAL_SHADER_LIGHTS_4;
+    if (pointLights <= 16) return MATERIAL_SHADER_LIGHTS_16;
+    return MATERIAL_SHADER_LIGHTS_32;
+}
+
+// std140 mirror of MaterialBlock in material.glsl
+struct MaterialConstants {
+    glm::vec4 kA;
+    glm::vec4 kD;
+    glm::vec4 kS;
+    float shine;
+    int useDiffuseMap;
+    int useSpecularMap;
+    int padding;
+};
+
+// what is currently bound, so consecutive Bind() calls only touch what changed
+struct MaterialBindState {
+    unsigned int ubo = 0;
+    unsigned int textures[MATERIAL_UNIT_COUNT] = { 0 };
+    unsigned int textureBinds = 0;
+    unsigned int textureBindsSaved = 0;
+};
+
+class Material {
+public:
+    unsigned int id = 0;            // small global index, used in render queue sort keys
+    unsigned int diffuseMap = 0;
+    unsigned int specularMap = 0;
+    unsigned int diffuseArray = 0;
+    MaterialConstants constants;
+    unsigned int UBO = 0;
+
+    Material() {}
+
+    // creates the uniform buffer; textures are optional (0 = none)
+    Material(const glm::vec3& kA, const glm::vec3& kD, const glm::vec3& kS, float shine,
+             unsigned int diffuseMap = 0, unsigned int specularMap = 0, const std::string& origin = "")
+    {
+        static unsigned int nextId = 1;
+        id = nextId++;
+
+        this->diffuseMap = diffuseMap;
+        this->specularMap = specularMap;
+        constants.kA = glm::vec4(kA, 1.0f);
+        constants.kD = glm::vec4(kD, 1.0f);
+        constants.kS = glm::vec4(kS, 1.0f);
+        constants.shine = shine;
+        constants.useDiffuseMap = diffuseMap != 0 ? MATERIAL_DIFFUSE_TEXTURE : MATERIAL_DIFFUSE_NONE;
+        constants.useSpecularMap = specularMap != 0;
+        constants.padding = 0;
+
+        glGenBuffers(1, &UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(MaterialConstants), &constants, GL_STATIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        trackResource(ResourceKind::Buffer, UBO, sizeof(MaterialConstants), "Material", origin);
+    }
+
+    // deletes the uniform buffer; copies of this material share it, so only the owner calls this
+    void Release()
+    {
+        if (UBO == 0) return;
+        glDeleteBuffers(1, &UBO);
+        untrackResource(ResourceKind::Buffer, UBO);
+        UBO = 0;
+    }
+
+    // switches the material to packed mode: diffuse comes from a texture array layer and a tint stored per vertex
+    void UsePackedDiffuse(unsigned int arrayTexture)
+    {
+        diffuseMap = 0;
+        diffuseArray = arrayTexture;
+        constants.useDiffuseMap = MATERIAL_DIFFUSE_PACKED;
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(MaterialConstants), &constants);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // the variant keys this material needs: which maps its shader samples
+    unsigned int ShaderFeatures() const
+    {
+        unsigned int features = 0;
+        if (constants.useDiffuseMap == MATERIAL_DIFFUSE_TEXTURE) features |= MATERIAL_SHADER_DIFFUSE_MAP;
+        if (constants.useDiffuseMap == MATERIAL_DIFFUSE_PACKED) features |= MATERIAL_SHADER_DIFFUSE_ARRAY;
+        if (constants.useSpecularMap) features |= MATERIAL_SHADER_SPECULAR_MAP;
+        return features;
+    }
+
+    // binds the constants and all textures with a single call
+    void Bind(MaterialBindState* state = nullptr) const
+    {
+        if (!state || state->ubo != UBO)
+        {
+            glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_UBO_BINDING, UBO);
+            if (state) state->ubo = UBO;
+        }
+
+        const unsigned int textures[MATERIAL_UNIT_COUNT] = { diffuseMap, specularMap, diffuseArray };
+        for (unsigned int unit = 0; unit < MATERIAL_UNIT_COUNT; unit++)
+        {
+            if (textures[unit] == 0) continue; // the shader won't sample it
+            if (state && state->textures[unit] == textures[unit])
+            {
+                state->textureBindsSaved++;
+                continue;
+            }
+            glActiveTexture(GL_TEXTURE0 + unit);
+            glBindTexture(unit == MATERIAL_UNIT_DIFFUSE_ARRAY ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D, textures[unit]);
+            if (state)
+            {
+                state->textures[unit] = textures[unit];
+                state->textureBinds++;
+            }
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // connects a program's MaterialBlock and material samplers to the fixed binding points; once per program
+    static void SetupProgram(Shader& shader)
+    {
+        unsigned int blockIndex = glGetUniformBlockIndex(shader.ID, "MaterialBlock");
+        if (blockIndex != GL_INVALID_INDEX)
+            glUniformBlockBinding(shader.ID, blockIndex, MATERIAL_UBO_BINDING);
+
+        shader.use();
+        shader.setInt("uDiffMap", MATERIAL_UNIT_DIFFUSE);
+        shader.setInt("uSpecMap", MATERIAL_UNIT_SPECULAR);
+        shader.setInt("uDiffArray", MATERIAL_UNIT_DIFFUSE_ARRAY);
+    }
+};
+#endif
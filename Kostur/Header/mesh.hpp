@@ -9,7 +9,15 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "shader.hpp"
+#include "ResourceRegistry.h"
+#include "material.hpp"
+#include "RenderQueue.h"
+#include "GeometryPool.h"
+#include "VertexFormat.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <string>
 #include <vector>
 using namespace std;
@@ -23,6 +31,100 @@ struct Vertex {
     glm::vec2 TexCoords;
 };
 
+// GPU-side formats. Vertex is the full fp32 layout; the compact variants store the normal as
+// 10:10:10:2 and the UVs as half floats (position stays fp32). The Packed variants append
+// the material stream used by Model packing.
+struct CompactVertex {
+    glm::vec3    Position;
+    PackedNormal Normal;
+    Half2        TexCoords;
+};
+
+struct PackedVertex {
+    glm::vec3 Position;
+    glm::vec3 Normal;
+    glm::vec2 TexCoords;
+    glm::vec4 Packing;  // rgb = diffuse tint, a = texture array layer
+};
+
+struct CompactPackedVertex {
+    glm::vec3    Position;
+    PackedNormal Normal;
+    Half2        TexCoords;
+    glm::vec4    Packing;
+};
+
+template<typename V> struct VertexLayoutOf;
+template<> struct VertexLayoutOf<Vertex> {
+    static const char* name() { return "P3N3T2"; }
+    typedef VertexLayout<Vertex, VERTEX_ATTRIB(Vertex, Position, 0), VERTEX_ATTRIB(Vertex, Normal, 1), VERTEX_ATTRIB(Vertex, TexCoords, 2)> type;
+};
+template<> struct VertexLayoutOf<CompactVertex> {
+    static const char* name() { return "P3N10T16"; }
+    typedef VertexLayout<CompactVertex, VERTEX_ATTRIB(CompactVertex, Position, 0), VERTEX_ATTRIB(CompactVertex, Normal, 1),
+                         VERTEX_ATTRIB(CompactVertex, TexCoords, 2)> type;
+};
+template<> struct VertexLayoutOf<PackedVertex> {
+    static const char* name() { return "P3N3T2+packing"; }
+    typedef VertexLayout<PackedVertex, VERTEX_ATTRIB(PackedVertex, Position, 0), VERTEX_ATTRIB(PackedVertex, Normal, 1),
+                         VERTEX_ATTRIB(PackedVertex, TexCoords, 2), VERTEX_ATTRIB(PackedVertex, Packing, 3)> type;
+};
+template<> struct VertexLayoutOf<CompactPackedVertex> {
+    static const char* name() { return "P3N10T16+packing"; }
+    typedef VertexLayout<CompactPackedVertex, VERTEX_ATTRIB(CompactPackedVertex, Position, 0), VERTEX_ATTRIB(CompactPackedVertex, Normal, 1),
+                         VERTEX_ATTRIB(CompactPackedVertex, TexCoords, 2), VERTEX_ATTRIB(CompactPackedVertex, Packing, 3)> type;
+};
+
+// converts the CPU-side vertex (plus its packing entry, if the format has one) into format V
+template<typename V> V MakeVertex(const Vertex& v, const glm::vec4& packing);
+
+template<> inline Vertex MakeVertex<Vertex>(const Vertex& v, const glm::vec4&)
+{
+    return v;
+}
+
+template<> inline CompactVertex MakeVertex<CompactVertex>(const Vertex& v, const glm::vec4&)
+{
+    CompactVertex c = { v.Position, packNormal(v.Normal), toHalf2(v.TexCoords) };
+    return c;
+}
+
+template<> inline PackedVertex MakeVertex<PackedVertex>(const Vertex& v, const glm::vec4& packing)
+{
+    PackedVertex p = { v.Position, v.Normal, v.TexCoords, packing };
+    return p;
+}
+
+template<> inline CompactPackedVertex MakeVertex<CompactPackedVertex>(const Vertex& v, const glm::vec4& packing)
+{
+    CompactPackedVertex c = { v.Position, packNormal(v.Normal), toHalf2(v.TexCoords), packing };
+    return c;
+}
+
+// one pool per vertex format and index type, shared by every mesh of every model
+template<typename V, typename I>
+GeometryPool& MeshPool()
+{
+    typedef typename VertexLayoutOf<V>::type Layout;
+    static GeometryPool pool(string(VertexLayoutOf<V>::name()) + (sizeof(I) == 2 ? " u16" : " u32"),
+                             Layout::stride(), Layout::attributes(), IndexTraits<I>::type());
+    return pool;
+}
+
+// one level of detail: a slice of the mesh's index data, drawn against the shared vertices
+struct MeshLod {
+    GLsizei firstIndex;     // relative to the mesh's first index
+    GLsizei indexCount;
+    float   error;          // object-space deviation from the full mesh
+};
+
+// what Submit needs to turn a LOD's object-space error into pixels
+struct LodContext {
+    glm::vec3 viewPos;
+    float pixelScale;       // screen height / (2 * tan(fovy / 2)): pixels covered by one unit at distance one
+    float maxPixelError;    // coarsest LOD whose projected error stays below this is used
+};
+
 struct Texture {
     unsigned int id;
     string type;
@@ -31,89 +133,185 @@ struct Texture {
 
 class Mesh {
 public:
-    // mesh Data
+    // mesh Data; vertices, indices and packing are emptied after upload unless the mesh keeps its CPU data
     vector<Vertex>       vertices;
-    vector<unsigned int> indices;
-    vector<Texture>      textures;
-    unsigned int VAO;
+    vector<unsigned int> indices;   // every LOD's indices, back to back
+    vector<MeshLod>      lods;      // finest first; lods[0] is the full mesh
+    Material*            material;
+    vector<glm::vec4>    packing;   // optional per-vertex stream: rgb = diffuse tint, a = texture array layer
+    size_t vertexCount = 0, indexCount = 0;     // as uploaded; still valid once the CPU copies are gone
+    unsigned int VAO;               // the pool's VAO, shared with every mesh of the same format
+    GeometryPool* pool = nullptr;
+    GeometryRange range;
+    GLenum indexType = GL_UNSIGNED_INT;
+    size_t gpuBytes = 0;            // vertex + index data as uploaded, after format selection
+    string origin;
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
 
-    // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    // constructor; without a LOD table the whole index list is a single level.
+    // the vectors are taken by value, so callers that std::move them in hand over their buffers without a copy.
+    // unless keepCpuData is set (serialization, CPU-side edits) the CPU copies are freed as soon as they are uploaded
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, Material* material, const string& origin = "",
+         vector<glm::vec4> packing = vector<glm::vec4>(), vector<MeshLod> lods = vector<MeshLod>(), bool keepCpuData = false)
+        : vertices(std::move(vertices)), indices(std::move(indices)), lods(std::move(lods)), material(material), packing(std::move(packing)),
+          origin(origin)
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        vertexCount = this->vertices.size();
+        indexCount = this->indices.size();
+        if (this->lods.empty())
+            this->lods.push_back({ 0, (GLsizei)indexCount, 0.0f });
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
         setupMesh();
+        if (keepCpuData) TrackCpuData();
+        else             ReleaseCpuData();
     }
 
     // render the mesh
     void Draw(Shader& shader)
     {
-        // bind appropriate textures
-        unsigned int diffuseNr = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr = 1;
-        for (unsigned int i = 0; i < textures.size(); i++)
-        {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            string number;
-            string name = textures[i].type;
-            if (name == "uDiffMap")
-                number = std::to_string(diffuseNr++);
-            else
-                number = std::to_string(specularNr++); // transfer unsigned int to string
-
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
-        }
+        // constants and textures go to fixed binding points, see Material::SetupProgram
+        if (material)
+            material->Bind();
 
         // draw mesh
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+        glDrawElementsBaseVertex(GL_TRIANGLES, lods[0].indexCount, indexType,
+                                 (void*)((range.firstIndex + lods[0].firstIndex) * indexSize(indexType)), range.baseVertex);
         glBindVertexArray(0);
+    }
+
+    // queue the mesh for sorted rendering, optionally with a different material than its own.
+    // with a LOD context the level is picked from its projected error, otherwise the full mesh is used.
+    // the program is the variant matching the material that is drawn
+    void Submit(RenderQueue& queue, RenderPass pass, ShaderVariants& shaders, const glm::mat4& model, const Material* overrideMaterial = nullptr,
+                const LodContext* lodContext = nullptr)
+    {
+        const Material* drawMaterial = overrideMaterial ? overrideMaterial : material;
+        const MeshLod& lod = lods[lodContext ? SelectLod(model, *lodContext) : 0];
+        queue.submitElements(pass, shaders, VAO, lod.indexCount, model, *drawMaterial, range.firstIndex + lod.firstIndex, range.baseVertex, indexType);
+    }
+
+    // coarsest level whose error, scaled by the model matrix and projected at the bounds' nearest point, is small enough
+    unsigned int SelectLod(const glm::mat4& model, const LodContext& context) const
+    {
+        float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        glm::vec3 center = glm::vec3(model * glm::vec4(boundsCenter, 1.0f));
+        float distance = std::max(glm::distance(context.viewPos, center) - boundsRadius * scale, 0.1f);
+
+        unsigned int chosen = 0;
+        for (unsigned int i = 1; i < lods.size(); i++)
+            if (lods[i].error * scale * context.pixelScale / distance <= context.maxPixelError)
+                chosen = i;
+        return chosen;
+    }
+
+    // frees vertices, indices and packing; the GPU copy, bounds and LOD table stay.
+    // swapping with empty vectors is what actually returns the capacity
+    void ReleaseCpuData()
+    {
+        vector<Vertex>().swap(vertices);
+        vector<unsigned int>().swap(indices);
+        vector<glm::vec4>().swap(packing);
+        if (cpuDataId) untrackResource(ResourceKind::CpuData, cpuDataId);
+        cpuDataId = 0;
+    }
+
+    // ids for CpuData entries in the resource registry, shared with Model's pick data
+    static unsigned int NextCpuDataId()
+    {
+        static unsigned int nextCpuDataId = 1;
+        return nextCpuDataId++;
+    }
 
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+    // returns the geometry to the pool; the mesh must not be drawn afterwards
+    void Release()
+    {
+        if (!pool) return;
+        pool->release(range);
+        ReleaseCpuData();
+        pool = nullptr;
+        range = GeometryRange();
     }
 
 private:
-    // render data 
-    unsigned int VBO, EBO;
+    unsigned int cpuDataId = 0;     // the VAO is shared, so CPU copies are tracked under a per-mesh id; 0 = none kept
+
+    // registers the CPU copies kept around after upload; the pool tracks its own buffers
+    void TrackCpuData()
+    {
+        cpuDataId = NextCpuDataId();
+        trackResource(ResourceKind::CpuData, cpuDataId, vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int)
+                      + packing.capacity() * sizeof(glm::vec4), "Mesh", origin);
+    }
 
-    // initializes all the buffer objects/arrays
+    // picks the smallest formats that represent this mesh well enough and uploads it into the matching pool:
+    // 16-bit indices whenever they can address every vertex, half-float UVs while they stay within [-2, 2]
+    // (at most 1/1024 error, under a texel for the textures we load). Normals always fit 10:10:10:2.
     void setupMesh()
     {
-        // create buffers/arrays
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+        // bounding sphere around the box center, for LOD selection
+        if (!vertices.empty())
+        {
+            glm::vec3 lo = vertices[0].Position, hi = vertices[0].Position;
+            for (size_t i = 1; i < vertices.size(); i++)
+            {
+                lo = glm::min(lo, vertices[i].Position);
+                hi = glm::max(hi, vertices[i].Position);
+            }
+            boundsCenter = (lo + hi) * 0.5f;
+            for (size_t i = 0; i < vertices.size(); i++)
+                boundsRadius = std::max(boundsRadius, glm::distance(boundsCenter, vertices[i].Position));
+        }
 
-        glBindVertexArray(VAO);
-        // load data into vertex buffers
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        // A great thing about structs is that their memory layout is sequential for all its items.
-        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-        // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-        // set the vertex attribute pointers
-        // vertex Positions
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+        bool shortIndices = vertices.size() <= 65536;
+        bool compact = true;
+        for (size_t i = 0; i < vertices.size() && compact; i++)
+            compact = std::fabs(vertices[i].TexCoords.x) <= 2.0f && std::fabs(vertices[i].TexCoords.y) <= 2.0f;
+
+        if (packing.empty())
+        {
+            if (compact) upload<CompactVertex>(shortIndices);
+            else         upload<Vertex>(shortIndices);
+        }
+        else
+        {
+            if (compact) upload<CompactPackedVertex>(shortIndices);
+            else         upload<PackedVertex>(shortIndices);
+        }
+    }
+
+    template<typename V>
+    void upload(bool shortIndices)
+    {
+        if (shortIndices) upload<V, uint16_t>();
+        else              upload<V, unsigned int>();
+    }
+
+    template<typename V, typename I>
+    void upload()
+    {
+        vector<V> converted;
+        converted.reserve(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++)
+            converted.push_back(MakeVertex<V>(vertices[i], packing.empty() ? glm::vec4(0.0f) : packing[i]));
+        vector<I> narrowed;
+        const I* indexData = IndexData(indices, narrowed);
+
+        pool = &MeshPool<V, I>();
+        range = pool->allocate(converted.data(), converted.size(), indexData, indices.size());
+        VAO = pool->vao();
+        indexType = IndexTraits<I>::type();
+        gpuBytes = converted.size() * sizeof(V) + indices.size() * sizeof(I);
+    }
+
+    // 32-bit indices are uploaded straight from the mesh; only 16-bit ones need a narrowed copy
+    static const unsigned int* IndexData(const vector<unsigned int>& indices, vector<unsigned int>&) { return indices.data(); }
+    static const uint16_t* IndexData(const vector<unsigned int>& indices, vector<uint16_t>& narrowed)
+    {
+        narrowed.assign(indices.begin(), indices.end());
+        return narrowed.data();
     }
 };
 #endif
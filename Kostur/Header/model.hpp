@@ -10,36 +10,156 @@
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <assimp/IOSystem.hpp>
+#include <assimp/IOStream.hpp>
 
 #include "mesh.hpp"
 #include "shader.hpp"
-
+#include "ResourceRegistry.h"
+#include "StartupTrace.h"
+#include "AssetManager.h"
+#include "AssetPack.h"
+#include "BackgroundLoader.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshBvh.h"
+
+#include <cstdio>
+#include <cstdlib>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <vector>
+#include <algorithm>
 
 using namespace std;
 
-unsigned int TextureFromFile(const char* path, const string& directory, bool gamma = false);
+// LOD chain: each level targets half the triangles of the previous one
+#define MODEL_MAX_LODS 4
+#define MODEL_LOD_MIN_TRIANGLES 64
+#define MODEL_LOD_MAX_ERROR 0.05f   // collapse error cap, as a fraction of the mesh's bounding box diagonal
+
+// every layer of a packed model's diffuse array, decoded and resampled, waiting for upload
+struct TextureArrayData {
+    string key;             // asset cache key: layer size and every layer's path
+    uint64_t contentHash = 0;
+    int size = 0;
+    int layers = 0;
+    vector<unsigned char> pixels;
+    string errors;          // one line per layer that failed to decode; the caller prints them
+};
+
+TextureArrayData DecodeTextureArray(const vector<string>& paths, const string& directory, int maxLayerSize);
+unsigned int UploadTextureArray(const TextureArrayData& data, const string& owner = "Model");
+bool ScanObjBounds(const string& path, glm::vec3& lo, glm::vec3& hi);
+
+// Assimp reads the model and every file it references (an OBJ's MTL) through this, so they
+// come out of the asset pack when one is open
+class AssetPackIOStream : public Assimp::IOStream
+{
+public:
+    explicit AssetPackIOStream(const AssetView& view) : view(view), position(0) {}
+
+    size_t Read(void* buffer, size_t size, size_t count) override
+    {
+        if (size == 0) return 0;
+        count = std::min(count, (view.size - position) / size);
+        memcpy(buffer, view.data + position, size * count);
+        position += size * count;
+        return count;
+    }
+    size_t Write(const void*, size_t, size_t) override { return 0; }
+    aiReturn Seek(size_t offset, aiOrigin origin) override
+    {
+        size_t base = origin == aiOrigin_SET ? 0 : origin == aiOrigin_CUR ? position : view.size;
+        if (origin == aiOrigin_END ? offset > view.size : base + offset > view.size) return aiReturn_FAILURE;
+        position = origin == aiOrigin_END ? view.size - offset : base + offset;
+        return aiReturn_SUCCESS;
+    }
+    size_t Tell() const override { return position; }
+    size_t FileSize() const override { return view.size; }
+    void Flush() override {}
+
+private:
+    AssetView view;
+    size_t position;
+};
+
+class AssetPackIOSystem : public Assimp::IOSystem
+{
+public:
+    bool Exists(const char* file) const override { return assetExists(file); }
+    char getOsSeparator() const override { return '/'; }
+    Assimp::IOStream* Open(const char* file, const char* mode = "rb") override
+    {
+        AssetView view;
+        if (strchr(mode, 'w') || strchr(mode, 'a') || !readAsset(file, view)) return nullptr;
+        return new AssetPackIOStream(view);
+    }
+    void Close(Assimp::IOStream* file) override { delete file; }
+};
+
+enum class ModelState {
+    Importing,  // a loader thread is reading the file; drawn as its bounding box
+    Uploading,  // imported; textures and meshes go to the GPU a few per frame, still drawn as a box
+    Ready,
+    Failed,
+    Unloaded
+};
 
 class Model
 {
 public:
     // model data 
-    vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+    vector<AssetHandle> textureAssets;  // keeps every texture this model uses loaded; shared with other models through the asset manager
+    vector<Material> materials;     // one per assimp material, created the first time a mesh uses it
     vector<Mesh>    meshes;
     string directory;
+    string path;
     bool gammaCorrection;
+    bool packTextures;      // merge all meshes into one, with every diffuse map in one texture array
+    int packedLayerSize;    // texture array layers are resampled to at most this many pixels per side
+    bool keepMeshData;      // meshes keep their vertices and indices after upload, for CPU-side queries
+    ModelState state = ModelState::Importing;   // main thread only
+    // object-space bounds of all meshes; a unit box until the loader has seen the positions
+    glm::vec3 boundsMin = glm::vec3(-0.5f), boundsMax = glm::vec3(0.5f);
+    // ray picking against the full-detail meshes (mesh i of the BVH is meshes[i]); null until Ready.
+    // immutable once built, so it can be shared with the simulation thread
+    shared_ptr<const ModelBvh> pickBvh;
+
+    // constructor, expects a filepath to a 3D model. Everything is loaded when it returns
+    Model(string const& path, bool gamma = false, bool packTextures = false, int packedLayerSize = 1024, bool keepMeshData = false)
+        : path(path), gammaCorrection(gamma), packTextures(packTextures), packedLayerSize(packedLayerSize), keepMeshData(keepMeshData)
+    {
+        importModel();
+        while (!uploadStep()) {}
+    }
 
-    // constructor, expects a filepath to a 3D model.
-    Model(string const& path, bool gamma = false) : gammaCorrection(gamma)
+    // returns at once; the import runs on a loader thread and the GL work is queued for processMainThreadWork,
+    // one texture or mesh per step. Until it is Ready, Submit draws the model's bounding box
+    static shared_ptr<Model> LoadAsync(string const& path, bool packTextures = false, int packedLayerSize = 1024, bool keepMeshData = false)
     {
-        loadModel(path);
+        shared_ptr<Model> model(new Model(Deferred(), path, packTextures, packedLayerSize, keepMeshData));
+        runInBackground([model]() {
+            // an OBJ's vertex lines are quick to scan, so the placeholder gets its real size long before the import ends
+            glm::vec3 lo, hi;
+            if (ScanObjBounds(model->path, lo, hi))
+                runOnMainThread([model, lo, hi]() {
+                    if (model->state == ModelState::Importing) { model->boundsMin = lo; model->boundsMax = hi; }
+                    return true;
+                });
+            model->importModel();
+            runOnMainThread([model]() { return model->uploadStep(); });
+        });
+        return model;
     }
 
+    bool IsReady() const { return state == ModelState::Ready; }
+    bool IsLoading() const { return state == ModelState::Importing || state == ModelState::Uploading; }
+
     // draws the model, and thus all its meshes
     void Draw(Shader& shader)
     {
@@ -47,24 +167,281 @@ public:
             meshes[i].Draw(shader);
     }
 
+    // submits all meshes to the render queue instead of drawing them immediately; a model that is
+    // still loading submits its bounding box as lines
+    void Submit(RenderQueue& queue, RenderPass pass, ShaderVariants& shaders, const glm::mat4& model, const Material* overrideMaterial = nullptr,
+                const LodContext* lodContext = nullptr)
+    {
+        if (state == ModelState::Importing || state == ModelState::Uploading)
+        {
+            glm::mat4 box = glm::translate(model, (boundsMin + boundsMax) * 0.5f);
+            box = glm::scale(box, glm::max(boundsMax - boundsMin, glm::vec3(1e-3f)));
+            // unlit whatever the pass: the box has no normals to light
+            const Material& material = PlaceholderMaterial();
+            queue.submitArrays(pass, shaders.select(material.ShaderFeatures()), PlaceholderBoxVAO(), GL_LINES, 0, 24, box, material);
+            return;
+        }
+        for (unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].Submit(queue, pass, shaders, model, overrideMaterial, lodContext);
+    }
+
+    // gives the geometry back to the shared pools so later models can reuse the space.
+    // safe while loading: whatever is still queued for upload is dropped
+    void Unload()
+    {
+        for (unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].Release();
+        meshes.clear();
+        for (unsigned int i = 0; i < materials.size(); i++)
+            materials[i].Release();
+        materials.clear();
+        textureAssets.clear();
+        pickBvh.reset();
+        untrackResource(ResourceKind::CpuData, pickDataId);
+        pickDataId = 0;
+        state = ModelState::Unloaded;
+    }
+
+    // deletes the placeholder material shared by every model that is still loading; once, at shutdown
+    static void ReleaseShared()
+    {
+        PlaceholderMaterial().Release();
+    }
+
 private:
-    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
-    void loadModel(string const& path)
+    struct Deferred {};
+    Model(Deferred, string const& path, bool packTextures, int packedLayerSize, bool keepMeshData)
+        : path(path), gammaCorrection(false), packTextures(packTextures), packedLayerSize(packedLayerSize), keepMeshData(keepMeshData)
+    {
+    }
+
+    // a material as read from the file; textures are indices into Imported::images
+    struct ImportedMaterial {
+        bool used = false;
+        glm::vec3 ambient, diffuse, specular;
+        float shininess = 32.0f;
+        int diffuseImage = -1, specularImage = -1;
+    };
+
+    struct ImportedMesh {
+        vector<Vertex> vertices;
+        vector<unsigned int> indices;
+        vector<glm::vec4> packing;
+        vector<MeshLod> lods;
+        unsigned int materialIndex = 0;
+    };
+
+    // what importModel() hands to uploadStep(); written by the loader thread only before the upload is queued
+    struct Imported {
+        bool ok = false;
+        double importMs = 0.0;
+        glm::vec3 boundsMin = glm::vec3(0.0f), boundsMax = glm::vec3(0.0f);
+        vector<DecodedTexture> images;
+        TextureArrayData layers;    // packed models only
+        vector<ImportedMaterial> materials;
+        vector<ImportedMesh> meshes;
+        shared_ptr<ModelBvh> pickBvh;
+
+        // upload progress
+        size_t nextImage = 0, nextMesh = 0;
+        size_t unquantizedBytes = 0;            // the meshes as fp32 vertices and 32-bit indices, summed before their CPU copies go
+        vector<unsigned int> imageTextures;     // GL names, in images order
+        bool layersUploaded = false, materialsBuilt = false;
+        unsigned int arrayTexture = 0;
+    } imported;
+    stringstream importLog;     // printed from the main thread, so messages of parallel imports don't interleave
+    unsigned int pickDataId = 0;    // registry id of the BVH, tracked as CPU data
+    // mesh data waiting to be merged when packing
+    struct StagedMesh {
+        vector<Vertex> vertices;
+        vector<unsigned int> indices;
+        unsigned int materialIndex;
+    };
+    vector<StagedMesh> staged;
+
+    // vertex cache statistics over all meshes of this import, weighted by triangles (ACMR) and vertices (ATVR)
+    struct CacheReport {
+        double acmr = 0.0, atvr = 0.0;
+        void add(const VertexCacheStats& stats, size_t triangles, size_t vertices) { acmr += stats.acmr * triangles; atvr += stats.atvr * vertices; }
+    };
+    CacheReport cacheBefore, cacheAfterTipsify, cacheAfter;
+    size_t optimizedTriangles = 0, optimizedVertices = 0;
+
+    // reads the file via ASSIMP and prepares everything that doesn't need GL: optimized geometry with its LODs,
+    // materials and decoded textures. Touches nothing the main thread reads, so it can run on a loader thread
+    void importModel()
     {
         // read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        if (isAssetPackOpen()) importer.SetIOHandler(new AssetPackIOSystem()); // the importer owns and deletes it
+        double importStart = startupNowMs();
+        // the OBJ importer emits one vertex per face corner; joining identical ones gives the cache optimizer and the
+        // simplifier shared vertices to work with. Tangents aren't used, and per-corner tangents would keep corners apart
+        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices);
         // check for errors
         if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
-            cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
+            importLog << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
             return;
         }
         // retrieve the directory path of the filepath
         directory = path.substr(0, path.find_last_of('/'));
+        imported.materials.resize(scene->mNumMaterials);
 
         // process ASSIMP's root node recursively
         processNode(scene->mRootNode, scene);
+
+        if (optimizedTriangles > 0)
+            importLog << path << ": ACMR " << cacheBefore.acmr / optimizedTriangles << " -> " << cacheAfterTipsify.acmr / optimizedTriangles
+                      << " (cache) -> " << cacheAfter.acmr / optimizedTriangles << " (overdraw), ATVR " << cacheBefore.atvr / optimizedVertices
+                      << " -> " << cacheAfter.atvr / optimizedVertices << endl;
+
+        if (packTextures)
+            packMeshes(scene);
+
+        bool first = true;
+        for (const ImportedMesh& mesh : imported.meshes)
+            for (const Vertex& vertex : mesh.vertices)
+            {
+                imported.boundsMin = first ? vertex.Position : glm::min(imported.boundsMin, vertex.Position);
+                imported.boundsMax = first ? vertex.Position : glm::max(imported.boundsMax, vertex.Position);
+                first = false;
+            }
+        buildPickBvh();
+
+        imported.importMs = startupNowMs() - importStart;
+        imported.ok = true;
+    }
+
+    // main thread: one unit of GL work per call (a texture, the materials, or a mesh). true once there is nothing left
+    bool uploadStep()
+    {
+        if (state == ModelState::Unloaded)
+        {
+            imported = Imported();
+            return true;
+        }
+        if (!imported.ok)
+        {
+            cout << importLog.str();
+            importLog.str("");
+            state = ModelState::Failed;
+            return true;
+        }
+
+        if (state == ModelState::Importing)
+        {
+            recordAssetTiming(path + " (import)", imported.importMs);
+            boundsMin = imported.boundsMin;
+            boundsMax = imported.boundsMax;
+            state = ModelState::Uploading;
+        }
+
+        // 1. textures; the asset manager shares them with every other model and scene object using the same file
+        if (imported.nextImage < imported.images.size())
+        {
+            DecodedTexture& image = imported.images[imported.nextImage++];
+            AssetHandle asset = acquireTexture(image, TextureVariant::Mipmapped, "Model");
+            imported.imageTextures.push_back(asset.id());
+            textureAssets.push_back(asset);
+            vector<unsigned char>().swap(image.pixels);
+            return false;
+        }
+        if (imported.layers.layers > 0 && !imported.layersUploaded)
+        {
+            // cached like any other texture, keyed by its layers and layer size
+            const TextureArrayData& layers = imported.layers;
+            AssetHandle arrayAsset = acquireAsset(AssetKind::Texture, layers.key, layers.contentHash, [&]() {
+                AssetData data;
+                data.glName = UploadTextureArray(layers);
+                unsigned int texture = data.glName;
+                data.unload = [texture]() {
+                    glDeleteTextures(1, &texture);
+                    untrackResource(ResourceKind::Texture, texture);
+                };
+                return data;
+            });
+            imported.arrayTexture = arrayAsset.id();
+            imported.layersUploaded = true;
+            textureAssets.push_back(arrayAsset);
+            return false;
+        }
+
+        // 2. materials; meshes keep pointers into this vector, so it is sized once and never grows
+        if (!imported.materialsBuilt)
+        {
+            materials.resize(imported.materials.size());
+            for (unsigned int i = 0; i < materials.size(); i++)
+            {
+                const ImportedMaterial& m = imported.materials[i];
+                if (!m.used) continue;
+                materials[i] = Material(m.ambient, m.diffuse, m.specular, m.shininess > 0.0f ? m.shininess : 32.0f,
+                                        m.diffuseImage < 0 ? 0 : imported.imageTextures[m.diffuseImage],
+                                        m.specularImage < 0 ? 0 : imported.imageTextures[m.specularImage],
+                                        path);
+            }
+            if (packTextures && !materials.empty())
+                materials[0].UsePackedDiffuse(imported.arrayTexture);
+            imported.materialsBuilt = true;
+            return false;
+        }
+
+        // 3. meshes
+        if (imported.nextMesh < imported.meshes.size())
+        {
+            if (imported.nextMesh == 0)
+                meshes.reserve(imported.meshes.size());
+            ImportedMesh& mesh = imported.meshes[imported.nextMesh++];
+            imported.unquantizedBytes += mesh.vertices.size() * (sizeof(Vertex) + (mesh.packing.empty() ? 0 : sizeof(glm::vec4)))
+                                       + mesh.indices.size() * sizeof(unsigned int);
+            // the staged vectors move into the mesh, which frees them after upload unless keepMeshData is set
+            meshes.push_back(Mesh(std::move(mesh.vertices), std::move(mesh.indices), &materials[mesh.materialIndex], path,
+                                  std::move(mesh.packing), std::move(mesh.lods), keepMeshData));
+            mesh = ImportedMesh();
+            if (imported.nextMesh < imported.meshes.size()) return false;
+        }
+
+        // formats are picked per mesh; report what that saved against fp32 vertices and 32-bit indices
+        size_t uploaded = 0;
+        for (unsigned int i = 0; i < meshes.size(); i++)
+            uploaded += meshes[i].gpuBytes;
+        importLog << path << ": " << meshes.size() << " meshes, " << uploaded / 1024 << " KB geometry (" << imported.unquantizedBytes / 1024
+                  << " KB unquantized)" << endl;
+
+        pickBvh = imported.pickBvh;
+        if (pickBvh)
+        {
+            pickDataId = Mesh::NextCpuDataId();
+            trackResource(ResourceKind::CpuData, pickDataId, pickBvh->bytes(), "Picking", path);
+        }
+        cout << importLog.str();
+        importLog.str("");
+
+        imported = Imported();
+        state = ModelState::Ready;
+        return true;
+    }
+
+    // one BVH per mesh over its full-detail level, built from the imported positions before the meshes
+    // take them over (and free them after upload). line and point meshes get an empty BVH
+    void buildPickBvh()
+    {
+        double start = startupNowMs();
+        shared_ptr<ModelBvh> bvh = make_shared<ModelBvh>();
+        bvh->meshes.resize(imported.meshes.size());
+        bvh->boundsMin = imported.boundsMin;
+        bvh->boundsMax = imported.boundsMax;
+        size_t nodes = 0;
+        for (unsigned int i = 0; i < imported.meshes.size(); i++)
+        {
+            const ImportedMesh& mesh = imported.meshes[i];
+            size_t fullIndices = mesh.lods.empty() ? mesh.indices.size() : (size_t)mesh.lods[0].indexCount;
+            if (mesh.vertices.empty() || fullIndices % 3 != 0) continue;
+            bvh->meshes[i].build(&mesh.vertices[0].Position.x, sizeof(Vertex), mesh.indices.data(), fullIndices / 3);
+            nodes += bvh->meshes[i].nodeCount();
+        }
+        importLog << path << ": pick BVH " << nodes << " nodes, " << bvh->bytes() / 1024 << " KB in " << startupNowMs() - start << " ms" << endl;
+        imported.pickBvh = bvh;
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
@@ -76,7 +453,15 @@ private:
             // the node object only contains indices to index the actual objects in the scene. 
             // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            if (packTextures)
+            {
+                StagedMesh s;
+                readMeshData(mesh, s.vertices, s.indices);
+                s.materialIndex = mesh->mMaterialIndex;
+                staged.push_back(std::move(s));
+            }
+            else
+                imported.meshes.push_back(processMesh(mesh, scene));
         }
         // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
         for (unsigned int i = 0; i < node->mNumChildren; i++)
@@ -86,13 +471,72 @@ private:
 
     }
 
-    Mesh processMesh(aiMesh* mesh, const aiScene* scene)
+    ImportedMesh processMesh(aiMesh* mesh, const aiScene* scene)
     {
         // data to fill
-        vector<Vertex> vertices;
-        vector<unsigned int> indices;
-        vector<Texture> textures;
+        ImportedMesh result;
+        readMeshData(mesh, result.vertices, result.indices);
+
+        // process materials
+        result.materialIndex = mesh->mMaterialIndex;
+        ImportedMaterial& material = imported.materials[mesh->mMaterialIndex];
+        if (!material.used)
+            material = processMaterial(scene->mMaterials[mesh->mMaterialIndex]);
+
+        result.lods = buildLods(result.vertices, result.indices);
+        return result;
+    }
+
+    // simplifies the mesh into coarser levels and appends their indices after the full mesh's.
+    // the chain ends early when a level no longer shrinks (seams and borders are locked) or hits the error cap.
+    // materials, one per vertex, keeps the boundaries between the parts of a packed mesh in place
+    vector<MeshLod> buildLods(const vector<Vertex>& vertices, vector<unsigned int>& indices, const vector<unsigned int>* materials = nullptr)
+    {
+        vector<MeshLod> lods;
+        lods.push_back({ 0, (GLsizei)indices.size(), 0.0f });
+        if (indices.empty() || indices.size() % 3 != 0) return lods;
+
+        glm::vec3 lo = vertices[0].Position, hi = vertices[0].Position;
+        for (size_t i = 1; i < vertices.size(); i++)
+        {
+            lo = glm::min(lo, vertices[i].Position);
+            hi = glm::max(hi, vertices[i].Position);
+        }
+        float maxError = glm::length(hi - lo) * MODEL_LOD_MAX_ERROR;
+
+        const vector<unsigned int> full(indices);
+        size_t target = full.size();
+        for (int level = 1; level < MODEL_MAX_LODS; level++)
+        {
+            target = target / 6 * 3;
+            if (target < 3 * MODEL_LOD_MIN_TRIANGLES) break;
+
+            float error;
+            vector<unsigned int> simplified = simplifyMesh(full, &vertices[0].Position.x, sizeof(Vertex), vertices.size(), target, maxError, &error,
+                                                           &vertices[0].TexCoords.x, sizeof(Vertex), materials ? &(*materials)[0] : nullptr);
+            if (simplified.size() > lods.back().indexCount * 0.9f) break;
+
+            optimizeVertexCache(simplified, vertices.size());
+            lods.push_back({ (GLsizei)indices.size(), (GLsizei)simplified.size(), error });
+            indices.insert(indices.end(), simplified.begin(), simplified.end());
+        }
+
+        if (lods.size() > 1)
+        {
+            importLog << path << ": LOD triangles";
+            for (unsigned int i = 0; i < lods.size(); i++)
+                importLog << (i ? " / " : " ") << lods[i].indexCount / 3 << " (" << lods[i].error << ")";
+            importLog << endl;
+        }
+        return lods;
+    }
 
+    // copies positions, normals, texture coordinates and triangle indices out of an assimp mesh
+    void readMeshData(aiMesh* mesh, vector<Vertex>& vertices, vector<unsigned int>& indices)
+    {
+        // the counts are known up front, so each vector is allocated once (faces are triangulated on import)
+        vertices.reserve(vertices.size() + mesh->mNumVertices);
+        indices.reserve(indices.size() + (size_t)mesh->mNumFaces * 3);
         // walk through each of the mesh's vertices
         for (unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
@@ -129,104 +573,316 @@ private:
         // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
         for (unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
-            aiFace face = mesh->mFaces[i];
+            const aiFace& face = mesh->mFaces[i];  // by reference: copying an aiFace allocates its index array
             // retrieve all indices of the face and store them in the indices vector
             for (unsigned int j = 0; j < face.mNumIndices; j++)
                 indices.push_back(face.mIndices[j]);
         }
-        // process materials
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-        // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
-        // as 'texture_diffuseN' where N is a sequential number ranging from 1 to MAX_SAMPLER_NUMBER. 
-        // Same applies to other texture as the following list summarizes:
-        // diffuse: texture_diffuseN
 
-        // 1. diffuse maps
-        vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "uDiffMap");
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-        // 2. specular maps
-        vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "uSpecMap");
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+        optimizeMeshData(vertices, indices);
+    }
 
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+    // reorders triangles for the post-transform cache, then for overdraw, then vertices for fetch locality.
+    // meshes keep the optimized order as their CPU copy, so anything that later serializes them stores it too
+    void optimizeMeshData(vector<Vertex>& vertices, vector<unsigned int>& indices)
+    {
+        if (indices.empty() || indices.size() % 3 != 0) return; // points and lines are left alone
+        size_t triangles = indices.size() / 3;
+
+        cacheBefore.add(analyzeVertexCache(indices, vertices.size()), triangles, vertices.size());
+        optimizeVertexCache(indices, vertices.size());
+        cacheAfterTipsify.add(analyzeVertexCache(indices, vertices.size()), triangles, vertices.size());
+        optimizeOverdraw(indices, &vertices[0].Position.x, sizeof(Vertex), vertices.size());
+
+        vector<unsigned int> remap = optimizeVertexFetch(indices, vertices.size());
+        vector<Vertex> reordered(remap.size());
+        for (size_t i = 0; i < remap.size(); i++)
+            reordered[i] = vertices[remap[i]];
+        vertices.swap(reordered);
+
+        cacheAfter.add(analyzeVertexCache(indices, vertices.size()), triangles, vertices.size());
+        optimizedTriangles += triangles;
+        optimizedVertices += vertices.size();
     }
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
-    // the required info is returned as a Texture struct.
-    vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, string typeName)
+    // merges all staged meshes into a single mesh so the whole model draws with one call.
+    // every distinct diffuse map becomes a layer of one GL_TEXTURE_2D_ARRAY; each vertex carries
+    // its material's diffuse color and layer (-1 = untextured) in a separate attribute stream.
+    // ambient, specular and shininess are shared, taken from the material covering the most triangles.
+    void packMeshes(const aiScene* scene)
     {
-        vector<Texture> textures;
-        for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
+        // 1. assign texture array layers
+        vector<string> layerFiles;
+        vector<int> materialLayer(scene->mNumMaterials, -1);
+        vector<bool> materialSeen(scene->mNumMaterials, false);
+        vector<size_t> materialTriangles(scene->mNumMaterials, 0);
+        for (unsigned int i = 0; i < staged.size(); i++)
         {
+            unsigned int m = staged[i].materialIndex;
+            materialTriangles[m] += staged[i].indices.size() / 3;
+            if (materialSeen[m]) continue;
+            materialSeen[m] = true;
+
+            aiMaterial* mat = scene->mMaterials[m];
+            if (mat->GetTextureCount(aiTextureType_DIFFUSE) == 0) continue;
             aiString str;
-            mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for (unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if (!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
-            }
+            mat->GetTexture(aiTextureType_DIFFUSE, 0, &str);
+
+            vector<string>::iterator it = std::find(layerFiles.begin(), layerFiles.end(), string(str.C_Str()));
+            materialLayer[m] = (int)(it - layerFiles.begin());
+            if (it == layerFiles.end())
+                layerFiles.push_back(str.C_Str());
+        }
+        if (!layerFiles.empty())
+        {
+            imported.layers = DecodeTextureArray(layerFiles, directory, packedLayerSize);
+            importLog << imported.layers.errors;
         }
-        return textures;
-    }
-};
 
+        // 2. concatenate geometry, rebasing indices
+        ImportedMesh merged;
+        size_t totalVertices = 0, totalIndices = 0;
+        for (unsigned int i = 0; i < staged.size(); i++)
+        {
+            totalVertices += staged[i].vertices.size();
+            totalIndices += staged[i].indices.size();
+        }
+        merged.vertices.reserve(totalVertices);
+        merged.indices.reserve(totalIndices);
+        merged.packing.reserve(totalVertices);
+        vector<unsigned int> vertexMaterials;
+        vertexMaterials.reserve(totalVertices);
+        for (unsigned int i = 0; i < staged.size(); i++)
+        {
+            unsigned int m = staged[i].materialIndex;
+            aiColor3D diffuse(1.0f, 1.0f, 1.0f);
+            scene->mMaterials[m]->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse);
+
+            unsigned int base = (unsigned int)merged.vertices.size();
+            merged.vertices.insert(merged.vertices.end(), staged[i].vertices.begin(), staged[i].vertices.end());
+            for (unsigned int j = 0; j < staged[i].indices.size(); j++)
+                merged.indices.push_back(staged[i].indices[j] + base);
+            merged.packing.insert(merged.packing.end(), staged[i].vertices.size(), glm::vec4(diffuse.r, diffuse.g, diffuse.b, (float)materialLayer[m]));
+            vertexMaterials.insert(vertexMaterials.end(), staged[i].vertices.size(), m);
+            staged[i] = StagedMesh();   // free each part once it's merged, so the peak is one copy plus a part
+        }
 
+        // 3. shared material
+        unsigned int dominant = (unsigned int)(std::max_element(materialTriangles.begin(), materialTriangles.end()) - materialTriangles.begin());
+        aiColor3D ambient(1.0f, 1.0f, 1.0f), specular(0.0f, 0.0f, 0.0f);
+        float shininess = 32.0f;
+        if (dominant < scene->mNumMaterials)
+        {
+            scene->mMaterials[dominant]->Get(AI_MATKEY_COLOR_AMBIENT, ambient);
+            scene->mMaterials[dominant]->Get(AI_MATKEY_COLOR_SPECULAR, specular);
+            scene->mMaterials[dominant]->Get(AI_MATKEY_SHININESS, shininess);
+        }
+        imported.materials.assign(1, ImportedMaterial());
+        ImportedMaterial& shared = imported.materials[0];
+        shared.used = true;
+        shared.ambient = glm::vec3(ambient.r, ambient.g, ambient.b);
+        shared.diffuse = glm::vec3(1.0f);
+        shared.specular = glm::vec3(specular.r, specular.g, specular.b);
+        shared.shininess = shininess;
+
+        importLog << "Packed " << staged.size() << " meshes of " << path << " into one draw with " << layerFiles.size() << " texture layers" << endl;
+        merged.lods = buildLods(merged.vertices, merged.indices, &vertexMaterials);
+        imported.meshes.push_back(std::move(merged));
+        staged.clear();
+    }
 
-unsigned int TextureFromFile(const char* path, const string& directory, bool gamma)
-{
-    string filename = string(path);
-    filename = directory + '/' + filename;
+    // reads assimp's colors, shininess and the first diffuse/specular map
+    ImportedMaterial processMaterial(aiMaterial* mat)
+    {
+        aiColor3D ambient(1.0f, 1.0f, 1.0f), diffuse(1.0f, 1.0f, 1.0f), specular(0.0f, 0.0f, 0.0f);
+        float shininess = 32.0f;
+        mat->Get(AI_MATKEY_COLOR_AMBIENT, ambient);
+        mat->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse);
+        mat->Get(AI_MATKEY_COLOR_SPECULAR, specular);
+        mat->Get(AI_MATKEY_SHININESS, shininess);
+
+        ImportedMaterial result;
+        result.used = true;
+        result.ambient = glm::vec3(ambient.r, ambient.g, ambient.b);
+        result.diffuse = glm::vec3(diffuse.r, diffuse.g, diffuse.b);
+        result.specular = glm::vec3(specular.r, specular.g, specular.b);
+        result.shininess = shininess;
+        // 1. diffuse maps
+        result.diffuseImage = loadMaterialTexture(mat, aiTextureType_DIFFUSE);
+        // 2. specular maps
+        result.specularImage = loadMaterialTexture(mat, aiTextureType_SPECULAR);
+        return result;
+    }
 
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
+    // decodes the material's first texture of a given type, once per file for the whole model.
+    // returns its index in imported.images, -1 if there is none or it failed to load
+    int loadMaterialTexture(aiMaterial* mat, aiTextureType type)
+    {
+        if (mat->GetTextureCount(type) == 0) return -1;
+        aiString str;
+        mat->GetTexture(type, 0, &str);
 
-    int width, height, nrComponents;
+        string file = canonicalAssetPath(this->directory + '/' + str.C_Str());
+        for (unsigned int i = 0; i < imported.images.size(); i++)
+            if (imported.images[i].path == file) return (int)i;
 
-    // Trazimo 3 komponente (R, G, B) eksplicitno
-    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 3);
+        DecodedTexture image;
+        if (!decodeTexture(file, TextureVariant::Mipmapped, image))
+        {
+            importLog << image.error << endl;
+            return -1;
+        }
+        imported.images.push_back(image);
+        return (int)imported.images.size() - 1;
+    }
 
-    if (data)
+    // unit wireframe cube around the origin, shared by every model that is still loading
+    static unsigned int PlaceholderBoxVAO()
     {
+        static unsigned int vao = 0;
+        if (vao) return vao;
+
+        // the 12 edges join corners that differ in one coordinate
+        vector<glm::vec3> lines;
+        for (int corner = 0; corner < 8; corner++)
+            for (int axis = 1; axis < 8; axis <<= 1)
+                if (!(corner & axis))
+                {
+                    int other = corner | axis;
+                    lines.push_back(glm::vec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1) - glm::vec3(0.5f));
+                    lines.push_back(glm::vec3(other & 1, (other >> 1) & 1, (other >> 2) & 1) - glm::vec3(0.5f));
+                }
 
-        GLenum format = GL_RGB;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        unsigned int vbo;
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, lines.size() * sizeof(glm::vec3), lines.data(), GL_STATIC_DRAW);
+        PositionLayout::apply();
+        glBindVertexArray(0);
+        trackResource(ResourceKind::VertexArray, vao, 0, "Model");
+        trackResource(ResourceKind::Buffer, vbo, lines.size() * sizeof(glm::vec3), "Model", "placeholder box");
+        return vao;
+    }
 
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    // flat gray: drawn with the unlit variant, which shows the ambient color
+    static Material& PlaceholderMaterial()
+    {
+        static Material material(glm::vec3(0.6f), glm::vec3(0.0f), glm::vec3(0.0f), 32.0f);
+        return material;
+    }
+};
 
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-        stbi_image_free(data);
+// decodes every image, resamples it (bilinear) to a common square size and lays it out as one layer of a
+// GL_TEXTURE_2D_ARRAY. The size is the largest input dimension, capped at maxLayerSize. No GL calls, so any thread
+TextureArrayData DecodeTextureArray(const vector<string>& paths, const string& directory, int maxLayerSize)
+{
+    TextureArrayData result;
+    result.key = "array@" + std::to_string(maxLayerSize);
+    vector<DecodedTexture> images(paths.size());
+    bool complete = true;
+    int size = 1;
+    for (unsigned int i = 0; i < paths.size(); i++)
+    {
+        string filename = directory + '/' + paths[i];
+        result.key += "|" + canonicalAssetPath(filename);
+        if (!decodeTexture(filename, TextureVariant::Mipmapped, images[i]))
+        {
+            result.errors += images[i].error + "\n";
+            complete = false;
+            continue;
+        }
+        result.contentHash = hashBytes(&images[i].contentHash, sizeof(images[i].contentHash), result.contentHash);
+        size = std::max(size, std::max(images[i].width, images[i].height));
     }
-    else
+    size = std::min(size, maxLayerSize);
+    // an array with a missing layer is only shared by key
+    result.contentHash = complete ? hashBytes(&maxLayerSize, sizeof(maxLayerSize), result.contentHash) : 0;
+
+    result.size = size;
+    result.layers = (int)paths.size();
+    result.pixels.assign((size_t)size * size * 3 * paths.size(), 255);
+    for (unsigned int i = 0; i < paths.size(); i++)
     {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
+        const DecodedTexture& image = images[i];
+        if (image.pixels.empty()) continue;
+        unsigned char* dst = &result.pixels[(size_t)size * size * 3 * i];
+        for (int y = 0; y < size; y++)
+        {
+            float sy = std::max(0.0f, (y + 0.5f) * image.height / size - 0.5f);
+            int y0 = std::min((int)sy, image.height - 1), y1 = std::min(y0 + 1, image.height - 1);
+            float fy = sy - y0;
+            for (int x = 0; x < size; x++)
+            {
+                float sx = std::max(0.0f, (x + 0.5f) * image.width / size - 0.5f);
+                int x0 = std::min((int)sx, image.width - 1), x1 = std::min(x0 + 1, image.width - 1);
+                float fx = sx - x0;
+                for (int c = 0; c < 3; c++)
+                {
+                    float top = image.pixels[(y0 * image.width + x0) * 3 + c] * (1.0f - fx) + image.pixels[(y0 * image.width + x1) * 3 + c] * fx;
+                    float bottom = image.pixels[(y1 * image.width + x0) * 3 + c] * (1.0f - fx) + image.pixels[(y1 * image.width + x1) * 3 + c] * fx;
+                    dst[(y * size + x) * 3 + c] = (unsigned char)(top * (1.0f - fy) + bottom * fy + 0.5f);
+                }
+            }
+        }
     }
+    return result;
+}
 
+unsigned int UploadTextureArray(const TextureArrayData& data, const string& owner)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB, data.size, data.size, (GLsizei)data.layers, 0, GL_RGB, GL_UNSIGNED_BYTE, data.pixels.data());
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    trackResource(ResourceKind::Texture, textureID, estimateTextureBytes(data.size, data.size, 3, true) * data.layers, owner, data.key);
     return textureID;
 }
-#endif
 
+// bounds of the "v x y z" lines of an OBJ file, without parsing anything else. false for other formats
+bool ScanObjBounds(const string& path, glm::vec3& lo, glm::vec3& hi)
+{
+    if (path.size() < 4 || path.compare(path.size() - 4, 4, ".obj") != 0) return false;
+    AssetView file;
+    if (!readAsset(path, file)) return false;
+
+    bool found = false;
+    const char* end = file.chars() + file.size;
+    for (const char* start = file.chars(); start < end; )
+    {
+        const char* newline = (const char*)memchr(start, '\n', end - start);
+        if (!newline) newline = end;
+        string line(start, newline);    // strtof needs a terminator, which a mapped view doesn't have
+        start = newline + 1;
+        if (line.compare(0, 2, "v ") != 0) continue;
+
+        glm::vec3 p;
+        const char* cursor = line.c_str() + 2;
+        bool parsed = true;
+        for (int axis = 0; axis < 3 && parsed; axis++)
+        {
+            char* next;
+            p[axis] = std::strtof(cursor, &next);
+            parsed = next != cursor;
+            cursor = next;
+        }
+        if (!parsed) continue;
+        lo = found ? glm::min(lo, p) : p;
+        hi = found ? glm::max(hi, p) : p;
+        found = true;
+    }
+    return found;
+}
+#endif
@@ -4,72 +4,148 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <functional>
 #include <string>
-#include <fstream>
-#include <sstream>
 #include <iostream>
+#include <vector>
 
+#include "StartupTrace.h"
+#include "AssetPack.h"
+
+// Sources go through a small preprocessor before GL sees them:
+//   #include "file"   is replaced by the file, resolved next to the including one. A file is
+//                     only included once per stage, so include cycles end there.
+//   defines           given to the constructor become "#define NAME" lines (or "#define NAME VALUE"
+//                     for "NAME=VALUE") right after #version, which is how variants are specialized.
+// "#line L F" directives keep compile errors pointing at the right file: F indexes sourceFiles.
 class Shader
 {
 public:
     unsigned int ID;
+    std::string vertexPath, fragmentPath;
+    std::vector<std::string> defines;
+    std::vector<std::string> sourceFiles;   // every file the program was built from, includes too
+    // per-program state that a relinked program loses (block bindings, sampler units); runs again after every reload
+    std::function<void(Shader&)> programSetup;
+    // the transforms set on every draw (-1 if the program doesn't use one), looked up once per linked program
+    GLint modelLocation = -1, normalLocation = -1, viewProjectionLocation = -1;
+
     // constructor generates the shader on the fly
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath)
-    {
-        // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        try
-        {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
-        }
-        catch (std::ifstream::failure& e)
-        {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
-        }
-        const char* vShaderCode = vertexCode.c_str();
-        const char* fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
+    Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string>& defines = std::vector<std::string>())
+        : vertexPath(vertexPath), fragmentPath(fragmentPath), defines(defines), pendingID(0), pendingVertex(0), pendingFragment(0)
+    {
+        ScopedAssetTimer timer(std::string(vertexPath) + " + " + fragmentPath + DefinesLabel(defines));
+        // 1. retrieve the vertex/fragment source code from the asset pack (or filePath) and expand it
+        std::string vertexSource, fragmentSource;
+        preprocess(vertexPath, defines, false, vertexSource, sourceFiles);
+        preprocess(fragmentPath, defines, false, fragmentSource, sourceFiles);
+        // 2. compile shaders and link the program
         unsigned int vertex, fragment;
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
+        ID = compileProgram(vertexSource, fragmentSource, vertex, fragment);
         checkCompileErrors(vertex, "VERTEX");
-        // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
         checkCompileErrors(fragment, "FRAGMENT");
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        cacheTransformLocations();
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
 
     }
+
+    // lets the driver compile and link on its own threads (GL_KHR_parallel_shader_compile): the GL calls
+    // return at once and GL_COMPLETION_STATUS_KHR tells when the result can be queried without waiting
+    static bool enableParallelCompile()
+    {
+        if (GLEW_KHR_parallel_shader_compile) glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        else if (GLEW_ARB_parallel_shader_compile) glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        return parallelCompile();
+    }
+    static bool parallelCompile()
+    {
+        return GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+    }
+
+    // starts compiling the files on disk (not the asset pack, which has them as they were packed) into a
+    // new program. ID stays the old program until pollReload swaps them
+    bool reload()
+    {
+        std::string vertexSource, fragmentSource;
+        std::vector<std::string> files;
+        bool read = preprocess(vertexPath, defines, true, vertexSource, files);
+        read = preprocess(fragmentPath, defines, true, fragmentSource, files) && read;
+        sourceFiles = files;   // an edit may have added or removed an include
+        if (!read) return false;
+        discardReload();
+        pendingID = compileProgram(vertexSource, fragmentSource, pendingVertex, pendingFragment);
+        return true;
+    }
+
+    // the defines as they appear in logs: " [LIT, LIGHTS_4]", empty without any
+    static std::string DefinesLabel(const std::vector<std::string>& defines)
+    {
+        if (defines.empty()) return "";
+        std::string label = " [";
+        for (size_t i = 0; i < defines.size(); i++)
+            label += (i ? ", " : "") + defines[i];
+        return label + "]";
+    }
+
+    // reads path (from the pack, or always from disk when loose), expands its includes and adds the
+    // defines after #version. files collects every file read; false if one couldn't be
+    static bool preprocess(const std::string& path, const std::vector<std::string>& defines, bool loose,
+                           std::string& source, std::vector<std::string>& files)
+    {
+        std::vector<std::string> included;
+        source.clear();
+        return expand(path, &defines, loose, source, files, included);
+    }
+
+    bool reloadPending() const { return pendingID != 0; }
+
+    // call between frames: once the driver has finished the reloaded program, makes it current if it
+    // linked and drops it (keeping the old one) if it didn't. With parallel compile this never waits;
+    // without, the status queries wait for whatever compiling is left. true when ID changed
+    bool pollReload()
+    {
+        if (!pendingID) return false;
+        if (parallelCompile())
+        {
+            GLint done = GL_FALSE;
+            glGetProgramiv(pendingID, GL_COMPLETION_STATUS_KHR, &done);
+            if (!done) return false;
+        }
+
+        bool linked = checkCompileErrors(pendingVertex, "VERTEX") & checkCompileErrors(pendingFragment, "FRAGMENT")
+                    & checkCompileErrors(pendingID, "PROGRAM");
+        unsigned int program = pendingID;
+        pendingID = 0;
+        glDeleteShader(pendingVertex);
+        glDeleteShader(pendingFragment);
+        if (!linked)
+        {
+            glDeleteProgram(program);
+            std::cout << "Shader reload failed, keeping the previous program: " << vertexPath << " + " << fragmentPath << std::endl;
+            return false;
+        }
+
+        glDeleteProgram(ID);
+        ID = program;
+        cacheTransformLocations();
+        if (programSetup) programSetup(*this);
+        std::cout << "Reloaded " << vertexPath << " + " << fragmentPath << std::endl;
+        return true;
+    }
+
+    void discardReload()
+    {
+        if (!pendingID) return;
+        glDeleteShader(pendingVertex);
+        glDeleteShader(pendingFragment);
+        glDeleteProgram(pendingID);
+        pendingID = 0;
+    }
     // activate the shader
     // ------------------------------------------------------------------------
     void use() const
@@ -134,11 +210,123 @@ public:
     {
         glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
     }
+    // by cached location, for uniforms set every draw
+    // ------------------------------------------------------------------------
+    void setMat3(GLint location, const glm::mat3& mat) const
+    {
+        glUniformMatrix3fv(location, 1, GL_FALSE, &mat[0][0]);
+    }
+    void setMat4(GLint location, const glm::mat4& mat) const
+    {
+        glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]);
+    }
 
 private:
+    // a reload in flight: compiled (or compiling) but not yet current
+    unsigned int pendingID, pendingVertex, pendingFragment;
+
+    void cacheTransformLocations()
+    {
+        modelLocation = glGetUniformLocation(ID, "uM");
+        normalLocation = glGetUniformLocation(ID, "uN");
+        viewProjectionLocation = glGetUniformLocation(ID, "uVP");
+    }
+
+    // appends path to source with its includes expanded. defines go after the #version line of the top file
+    // (nullptr for included ones); included lists the files of this stage so far, each is expanded only once
+    static bool expand(const std::string& path, const std::vector<std::string>* defines, bool loose, std::string& source,
+                       std::vector<std::string>& files, std::vector<std::string>& included)
+    {
+        // listed even if it can't be read, so creating or fixing it triggers a reload
+        std::vector<std::string>::iterator known = std::find(files.begin(), files.end(), path);
+        size_t fileIndex = known - files.begin();
+        if (known == files.end()) files.push_back(path);
+        included.push_back(path);
+
+        AssetView file;
+        if (!(loose ? readLooseAsset(path, file) : readAsset(path, file)))
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+            return false;
+        }
+        std::string directory = path.substr(0, path.find_last_of('/') + 1);
+
+        const char* text = file.chars();
+        size_t size = file.size, lineNumber = 0;
+        bool ok = true;
+        for (size_t start = 0; start < size; )
+        {
+            size_t end = start;
+            while (end < size && text[end] != '\n') end++;
+            std::string line(text + start, end - start);
+            start = end + 1;
+            lineNumber++;
+
+            size_t first = line.find_first_not_of(" \t");
+            if (first != std::string::npos && line.compare(first, 8, "#include") == 0)
+            {
+                size_t open = line.find('"', first), close = open == std::string::npos ? open : line.find('"', open + 1);
+                if (close == std::string::npos)
+                {
+                    std::cout << "ERROR::SHADER::BAD_INCLUDE: " << path << ":" << lineNumber << std::endl;
+                    ok = false;
+                    continue;
+                }
+                std::string target = directory + line.substr(open + 1, close - open - 1);
+                if (std::find(included.begin(), included.end(), target) == included.end())
+                {
+                    size_t targetIndex = std::find(files.begin(), files.end(), target) - files.begin();
+                    source += "#line 1 " + std::to_string(targetIndex) + "\n";
+                    ok = expand(target, nullptr, loose, source, files, included) && ok;
+                    source += "\n";
+                }
+                source += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+                continue;
+            }
+
+            source += line;
+            source += '\n';
+            if (defines && first != std::string::npos && line.compare(first, 8, "#version") == 0)
+            {
+                for (const std::string& define : *defines)
+                {
+                    std::string name = define, value;
+                    size_t equals = define.find('=');
+                    if (equals != std::string::npos) { name = define.substr(0, equals); value = " " + define.substr(equals + 1); }
+                    source += "#define " + name + value + "\n";
+                }
+                source += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+                defines = nullptr;
+            }
+        }
+        return ok;
+    }
+
+    // issues compile and link without querying any status, so with parallel compile nothing here waits
+    static unsigned int compileProgram(const std::string& vertexSource, const std::string& fragmentSource, unsigned int& vertex, unsigned int& fragment)
+    {
+        const char* vShaderCode = vertexSource.c_str();
+        const char* fShaderCode = fragmentSource.c_str();
+        GLint vShaderLength = (GLint)vertexSource.size(), fShaderLength = (GLint)fragmentSource.size();
+        // vertex shader
+        vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex, 1, &vShaderCode, &vShaderLength);
+        glCompileShader(vertex);
+        // fragment Shader
+        fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragment, 1, &fShaderCode, &fShaderLength);
+        glCompileShader(fragment);
+        // shader Program
+        unsigned int program = glCreateProgram();
+        glAttachShader(program, vertex);
+        glAttachShader(program, fragment);
+        glLinkProgram(program);
+        return program;
+    }
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
-    void checkCompileErrors(GLuint shader, std::string type)
+    bool checkCompileErrors(GLuint shader, std::string type)
     {
         GLint success;
         GLchar infoLog[1024];
@@ -148,7 +336,10 @@ private:
             if (!success)
             {
                 glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << DefinesLabel(defines) << "\n" << infoLog;
+                for (size_t i = 0; i < sourceFiles.size(); i++)
+                    std::cout << "  file " << i << ": " << sourceFiles[i] << "\n";
+                std::cout << " -- --------------------------------------------------- -- " << std::endl;
             }
         }
         else
@@ -160,6 +351,7 @@ private:
                 std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
             }
         }
+        return success != 0;
     }
 };
 #endif
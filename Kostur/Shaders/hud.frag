@@ -0,0 +1,12 @@
+#version 330 core
+in vec2 TexCoords;
+in vec4 Color;
+out vec4 FragColor;
+
+// sprites as they are; the glyph atlas reads as white with coverage in alpha
+uniform sampler2D uTexture;
+
+void main()
+{
+    FragColor = Color * texture(uTexture, TexCoords);
+}
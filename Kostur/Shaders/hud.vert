@@ -0,0 +1,16 @@
+#version 330 core
+layout (location = 0) in vec2 aPos;     // screen pixels
+layout (location = 1) in vec2 aTexCoords;
+layout (location = 2) in vec4 aColor;
+
+out vec2 TexCoords;
+out vec4 Color;
+
+uniform mat4 uProjection;
+
+void main()
+{
+    gl_Position = uProjection * vec4(aPos, 0.0, 1.0);
+    TexCoords = aTexCoords;
+    Color = aColor;
+}
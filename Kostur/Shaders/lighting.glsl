@@ -0,0 +1,83 @@
+// Sun and pin lights. The number of point lights is a variant key: LIGHTS_4, LIGHTS_16
+// or LIGHTS_32 size the array (and bound the loop), without any of them there is none.
+
+// ---------------- STRUCT DEFINITIONS ----------------
+struct DirLight { // Sun
+    vec3 direction; // Light direction (not position!)
+    
+    vec3 kA;
+    vec3 kD;
+    vec3 kS;
+};
+
+struct PointLight { // Pin lights
+    vec3 position;
+    
+    float constant;
+    float linear;
+    float quadratic;
+    
+    vec3 kA;
+    vec3 kD;
+    vec3 kS;
+};
+
+#if defined(LIGHTS_32)
+#define NR_POINT_LIGHTS 32
+#elif defined(LIGHTS_16)
+#define NR_POINT_LIGHTS 16
+#elif defined(LIGHTS_4)
+#define NR_POINT_LIGHTS 4
+#endif
+
+uniform DirLight uSun; // Renamed to 'uSun' for clarity
+#ifdef NR_POINT_LIGHTS
+uniform PointLight pointLights[NR_POINT_LIGHTS];
+uniform int uNrActiveLights;
+#endif
+
+// 1. Calculate Sun (Directional Light)
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
+{
+    vec3 lightDir = normalize(-light.direction);
+    
+    // Diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    
+    // Specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), uMaterial.shine);
+    
+    // Combine
+    vec3 ambient = light.kA * uMaterial.kA.rgb;
+    vec3 diffuse = light.kD * (diff * MaterialDiffuse());
+    vec3 specular = light.kS * (spec * MaterialSpecular());
+    return (ambient + diffuse + specular);
+}
+
+// 2. Calculate Pin Lights (Point Light)
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    
+    // Diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    
+    // Specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), uMaterial.shine);
+    
+    // Attenuation
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
+    
+    // Combine
+    vec3 ambient = light.kA * uMaterial.kA.rgb;
+    vec3 diffuse = light.kD * (diff * MaterialDiffuse());
+    vec3 specular = light.kS * (spec * MaterialSpecular());
+    
+    ambient *= attenuation;
+    diffuse *= attenuation;
+    specular *= attenuation;
+    return (ambient + diffuse + specular);
+}
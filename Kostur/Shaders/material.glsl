@@ -0,0 +1,49 @@
+// Material constants and maps, shared by every program that shades a Material.
+// Which maps exist is decided per variant (see ShaderVariants): DIFFUSE_MAP,
+// DIFFUSE_ARRAY and SPECULAR_MAP are defined by the renderer from the material.
+
+// Per-material constants, one UBO per material (see Header/material.hpp)
+layout (std140) uniform MaterialBlock {
+    vec4 kA;    // Ambient color (rgb)
+    vec4 kD;    // Diffuse color (rgb)
+    vec4 kS;    // Specular color (rgb)
+    float shine;
+    int useDiffuseMap;  // 0 = none, 1 = uDiffMap, 2 = uDiffArray layer from Packed.a
+    int useSpecularMap;
+} uMaterial;
+
+uniform sampler2D uDiffMap; // Diffuse texture, unit 0
+uniform sampler2D uSpecMap; // Specular texture, unit 1
+uniform sampler2DArray uDiffArray; // Packed diffuse textures, unit 2
+
+// Diffuse color; packed models carry it per vertex
+vec3 MaterialDiffuse()
+{
+#ifdef DIFFUSE_ARRAY
+    return uMaterial.kD.rgb * Packed.rgb;
+#else
+    return uMaterial.kD.rgb;
+#endif
+}
+
+// Specular color, modulated by the specular map when the material has one
+vec3 MaterialSpecular()
+{
+#ifdef SPECULAR_MAP
+    return uMaterial.kS.rgb * texture(uSpecMap, TexCoords).rgb;
+#else
+    return uMaterial.kS.rgb;
+#endif
+}
+
+// Texture color the lighting result is multiplied with (white if there is no texture)
+vec4 MaterialTexture()
+{
+#if defined(DIFFUSE_MAP)
+    return texture(uDiffMap, TexCoords);
+#elif defined(DIFFUSE_ARRAY)
+    return Packed.a >= 0.0 ? texture(uDiffArray, vec3(TexCoords, Packed.a)) : vec4(1.0);
+#else
+    return vec4(1.0);
+#endif
+}
@@ -1,102 +1,28 @@
 #version 330 core
 out vec4 FragColor;
 
-// ---------------- STRUCT DEFINITIONS ----------------
-struct Material {
-    vec3 kA;    // Ambient color
-    vec3 kD;    // Diffuse color
-    vec3 kS;    // Specular color
-    float shine;
-};
-
-struct DirLight { // Sun
-    vec3 direction; // Light direction (not position!)
-    
-    vec3 kA;
-    vec3 kD;
-    vec3 kS;
-};
-
-struct PointLight { // Pin lights
-    vec3 position;
-    
-    float constant;
-    float linear;
-    float quadratic;
-    
-    vec3 kA;
-    vec3 kD;
-    vec3 kS;
-};
-
-#define NR_POINT_LIGHTS 32
+// Compiled in variants (see Header/ShaderVariants.h): LIT adds the sun and the pin
+// lights; an unlit variant (the wireframe box of a model still loading, which has no
+// normals) is just the material's ambient color times its texture. Material maps and
+// the light count are keys too, see the includes.
 
 // ---------------- INPUT VARIABLES ----------------
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
+flat in vec4 Packed;
 
 // ---------------- UNIFORMS ----------------
 uniform vec3 uViewPos;
-uniform Material uMaterial;
 
-uniform DirLight uSun; // Renamed to 'uSun' for clarity
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform int uNrActiveLights;
-
-uniform sampler2D uTexture; // Texture
-uniform int uUseTexture;    // Should we use the texture?
-
-// ---------------- FUNCTIONS ----------------
-
-// 1. Calculate Sun (Directional Light)
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
-{
-    vec3 lightDir = normalize(-light.direction);
-    
-    // Diffuse shading
-    float diff = max(dot(normal, lightDir), 0.0);
-    
-    // Specular shading
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), uMaterial.shine);
-    
-    // Combine
-    vec3 ambient = light.kA * uMaterial.kA;
-    vec3 diffuse = light.kD * (diff * uMaterial.kD);
-    vec3 specular = light.kS * (spec * uMaterial.kS);
-    return (ambient + diffuse + specular);
-}
-
-// 2. Calculate Pin Lights (Point Light)
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
-{
-    vec3 lightDir = normalize(light.position - fragPos);
-    
-    // Diffuse shading
-    float diff = max(dot(normal, lightDir), 0.0);
-    
-    // Specular shading
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), uMaterial.shine);
-    
-    // Attenuation
-    float distance = length(light.position - fragPos);
-    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
-    
-    // Combine
-    vec3 ambient = light.kA * uMaterial.kA;
-    vec3 diffuse = light.kD * (diff * uMaterial.kD);
-    vec3 specular = light.kS * (spec * uMaterial.kS);
-    
-    ambient *= attenuation;
-    diffuse *= attenuation;
-    specular *= attenuation;
-    return (ambient + diffuse + specular);
-}
+#include "material.glsl"
+#ifdef LIT
+#include "lighting.glsl"
+#endif
 
 void main()
 {
+#ifdef LIT
     // Properties
     vec3 norm = normalize(Normal);
     vec3 viewDir = normalize(uViewPos - FragPos);
@@ -108,14 +34,14 @@ void main()
     result += CalcDirLight(uSun, norm, viewDir);
 
     // 3. Add Pin Lights contribution
-    for(int i = 0; i < uNrActiveLights; i++)
+#ifdef NR_POINT_LIGHTS
+    for(int i = 0; i < NR_POINT_LIGHTS && i < uNrActiveLights; i++)
         result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);
+#endif
+#else
+    vec3 result = uMaterial.kA.rgb;
+#endif
 
     // 4. Apply Texture (Multiply light result with pixel color)
-    vec4 texColor = vec4(1.0); // Default white if no texture is present
-    if(uUseTexture == 1) {
-        texColor = texture(uTexture, TexCoords);
-    }
-    
-    FragColor = vec4(result, 1.0) * texColor;
+    FragColor = vec4(result, 1.0) * MaterialTexture();
 }
\ No newline at end of file
@@ -2,20 +2,23 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in vec4 aPacked; // packed models only: diffuse tint (rgb) and texture array layer (a)
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
+flat out vec4 Packed;
 
 uniform mat4 uM;
-uniform mat4 uV;
-uniform mat4 uP;
+uniform mat3 uN;    // normal matrix, computed per object on the CPU (see RenderQueue)
+uniform mat4 uVP;   // projection * view, once per pass
 
 void main()
 {
     FragPos = vec3(uM * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(uM))) * aNormal;  
+    Normal = uN * aNormal;
     TexCoords = aTexCoords;
+    Packed = aPacked;
     
-    gl_Position = uP * uV * vec4(FragPos, 1.0);
+    gl_Position = uVP * vec4(FragPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,20 @@
+#version 330 core
+flat in vec4 Segment;
+out vec4 FragColor;
+
+uniform vec4 uColor;
+uniform float uHalfWidth;   // pixels
+
+void main()
+{
+    // distance from the pixel center to the segment: a capsule, so joins come out round
+    vec2 start = Segment.xy;
+    vec2 segment = Segment.zw - Segment.xy;
+    vec2 offset = gl_FragCoord.xy - start;
+    float t = clamp(dot(offset, segment) / max(dot(segment, segment), 1e-6), 0.0, 1.0);
+    float pixelDistance = length(offset - segment * t);
+
+    float coverage = clamp(uHalfWidth + 0.5 - pixelDistance, 0.0, 1.0);
+    if (coverage <= 0.0) discard;
+    FragColor = vec4(uColor.rgb, uColor.a * coverage);
+}
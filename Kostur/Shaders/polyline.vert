@@ -0,0 +1,51 @@
+#version 330 core
+// one instance per segment (see PolylineRenderer)
+layout (location = 0) in vec3 aStart;
+layout (location = 1) in vec3 aEnd;
+
+uniform mat4 uVP;
+uniform vec4 uViewport;     // x, y, width, height of the glViewport, in framebuffer pixels
+uniform float uHalfWidth;   // pixels
+
+flat out vec4 Segment;      // start and end in window coordinates
+
+// moves a onto the near plane if it is behind it
+vec4 clipToNear(vec4 a, vec4 b)
+{
+    float da = a.z + a.w, db = b.z + b.w;
+    return da < 0.0 ? mix(a, b, da / (da - db)) : a;
+}
+
+void main()
+{
+    vec4 start = uVP * vec4(aStart, 1.0);
+    vec4 end = uVP * vec4(aEnd, 1.0);
+    if (start.z + start.w < 0.0 && end.z + end.w < 0.0) {
+        // wholly behind the camera: a degenerate quad outside the view
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        Segment = vec4(0.0);
+        return;
+    }
+    vec4 clippedStart = clipToNear(start, end);
+    vec4 clippedEnd = clipToNear(end, start);
+    vec3 ndcStart = clippedStart.xyz / clippedStart.w;
+    vec3 ndcEnd = clippedEnd.xyz / clippedEnd.w;
+    // window coordinates, the space gl_FragCoord is in
+    vec2 screenStart = uViewport.xy + (ndcStart.xy * 0.5 + 0.5) * uViewport.zw;
+    vec2 screenEnd = uViewport.xy + (ndcEnd.xy * 0.5 + 0.5) * uViewport.zw;
+
+    vec2 direction = screenEnd - screenStart;
+    float screenLength = length(direction);
+    direction = screenLength > 1e-4 ? direction / screenLength : vec2(1.0, 0.0);
+    vec2 normal = vec2(-direction.y, direction.x);
+
+    // corner of the strip: along 0 or 1, side -1 or 1. The quad reaches past both ends
+    // for the round caps, and one pixel past the width for the anti-aliased edge
+    float along = float(gl_VertexID & 1);
+    float side = float(gl_VertexID >> 1) * 2.0 - 1.0;
+    float radius = uHalfWidth + 1.0;
+    vec2 corner = mix(screenStart, screenEnd, along) + direction * (along * 2.0 - 1.0) * radius + normal * side * radius;
+
+    gl_Position = vec4((corner - uViewport.xy) / uViewport.zw * 2.0 - 1.0, mix(ndcStart.z, ndcEnd.z, along), 1.0);
+    Segment = vec4(screenStart, screenEnd);
+}
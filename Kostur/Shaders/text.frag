@@ -7,6 +7,6 @@ uniform vec3 textColor;
 
 void main()
 {    
-    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords).r);
+    vec4 sampled = texture(text, TexCoords); // the atlas reads as white with coverage in alpha
     color = vec4(textColor, 1.0) * sampled;
 }
\ No newline at end of file
@@ -0,0 +1,569 @@
+#include "../Header/AssetManager.h"
+#include "../Header/AssetPack.h"
+#include "../Header/BackgroundLoader.h"
+#include "../Header/ResourceRegistry.h"
+#include "../Header/StartupTrace.h"
+#include "../Header/shader.hpp"
+#include "../Header/stb_image.h"
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+struct AssetEntry {
+    bool alive = false;
+    AssetKind kind = AssetKind::Texture;
+    std::vector<std::string> keys;      // every key that resolved to this asset
+    uint64_t contentHash = 0;
+    AssetData data;
+    int refs = 0;
+    uint64_t lastUse = 0;
+};
+
+static std::vector<AssetEntry> entries;
+static std::vector<int> freeSlots;
+static std::unordered_map<std::string, int> slotByKey;
+static std::unordered_map<uint64_t, int> slotByContent;
+static uint64_t useCounter = 0;
+static AssetStats counters;
+static bool evicting = false;
+
+static std::string kindKey(AssetKind kind, const std::string& key)
+{
+    return std::to_string((int)kind) + ":" + key;
+}
+
+static uint64_t kindHash(AssetKind kind, uint64_t contentHash)
+{
+    int k = (int)kind;
+    return hashBytes(&k, sizeof(k), contentHash);
+}
+
+static void evict(int slot)
+{
+    AssetEntry& entry = entries[slot];
+    for (const std::string& key : entry.keys) slotByKey.erase(key);
+    if (entry.contentHash) slotByContent.erase(kindHash(entry.kind, entry.contentHash));
+
+    AssetData data = std::move(entry.data);
+    entry = AssetEntry();
+    freeSlots.push_back(slot);
+    counters.evictions++;
+
+    // may release handles to other assets (a model's textures); those are picked up by the caller's loop
+    if (data.unload) data.unload();
+}
+
+static int leastRecentlyUsedUnreferenced()
+{
+    int best = -1;
+    for (int i = 0; i < (int)entries.size(); i++)
+        if (entries[i].alive && entries[i].refs == 0 && (best < 0 || entries[i].lastUse < entries[best].lastUse))
+            best = i;
+    return best;
+}
+
+static void evictOverBudget()
+{
+    if (evicting || memoryBudget() == 0) return;
+    evicting = true;
+    while (trackedBytes() > memoryBudget()) {
+        int slot = leastRecentlyUsedUnreferenced();
+        if (slot < 0) break;
+        evict(slot);
+    }
+    evicting = false;
+}
+
+void purgeUnreferencedAssets()
+{
+    evicting = true;
+    for (int slot = leastRecentlyUsedUnreferenced(); slot >= 0; slot = leastRecentlyUsedUnreferenced())
+        evict(slot);
+    evicting = false;
+}
+
+// --- handles ---
+
+AssetHandle::AssetHandle(int slot)
+    : slot(slot)
+{
+    entries[slot].refs++;
+    entries[slot].lastUse = ++useCounter;
+}
+
+AssetHandle::AssetHandle(const AssetHandle& other)
+    : slot(other.slot)
+{
+    if (slot >= 0) entries[slot].refs++;
+}
+
+AssetHandle& AssetHandle::operator=(const AssetHandle& other)
+{
+    if (other.slot >= 0) entries[other.slot].refs++;
+    reset();
+    slot = other.slot;
+    return *this;
+}
+
+AssetHandle::~AssetHandle()
+{
+    reset();
+}
+
+void AssetHandle::reset()
+{
+    if (slot < 0) return;
+    int released = slot;
+    slot = -1;
+    if (--entries[released].refs == 0) evictOverBudget();
+}
+
+unsigned int AssetHandle::id() const
+{
+    return slot >= 0 ? entries[slot].data.glName : 0;
+}
+
+void* AssetHandle::object() const
+{
+    return slot >= 0 ? entries[slot].data.object.get() : nullptr;
+}
+
+// --- lookup ---
+
+static int findByKey(AssetKind kind, const std::string& key)
+{
+    auto it = slotByKey.find(kindKey(kind, key));
+    return it == slotByKey.end() ? -1 : it->second;
+}
+
+AssetHandle acquireAsset(AssetKind kind, const std::string& key, uint64_t contentHash, const std::function<AssetData()>& load)
+{
+    int slot = findByKey(kind, key);
+    if (slot >= 0) {
+        counters.keyHits++;
+        return AssetHandle(slot);
+    }
+
+    if (contentHash) {
+        auto it = slotByContent.find(kindHash(kind, contentHash));
+        if (it != slotByContent.end()) {
+            // same bytes under another path: remember this path too
+            entries[it->second].keys.push_back(kindKey(kind, key));
+            slotByKey[kindKey(kind, key)] = it->second;
+            counters.contentHits++;
+            return AssetHandle(it->second);
+        }
+    }
+
+    // the loader may acquire other assets, so no entry references are held across it
+    AssetData data = load();
+    if (!data.object && data.glName == 0) return AssetHandle();
+
+    if (freeSlots.empty()) {
+        slot = (int)entries.size();
+        entries.push_back(AssetEntry());
+    }
+    else {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    AssetEntry& entry = entries[slot];
+    entry.alive = true;
+    entry.kind = kind;
+    entry.keys.push_back(kindKey(kind, key));
+    entry.contentHash = contentHash;
+    entry.data = std::move(data);
+    slotByKey[entry.keys.back()] = slot;
+    if (contentHash) slotByContent[kindHash(kind, contentHash)] = slot;
+    counters.loads++;
+
+    AssetHandle handle(slot);
+    evictOverBudget();
+    return handle;
+}
+
+// --- textures ---
+
+static std::string textureKey(const std::string& canonical, TextureVariant variant, int downsampleTo)
+{
+    return canonical + (variant == TextureVariant::Flipped ? "#flipped" : "#mipmapped") + (downsampleTo > 0 ? "@" + std::to_string(downsampleTo) : "");
+}
+
+// 1, 2, 4 or 8: the strongest downsampling that keeps the longer side at least downsampleTo
+static int downsampleFactor(int width, int height, int downsampleTo)
+{
+    int factor = 1;
+    while (downsampleTo > 0 && factor < 8 && std::max(width, height) / (factor * 2) >= downsampleTo) factor *= 2;
+    return factor;
+}
+
+// box-filters factor x factor blocks (partial ones at the right and bottom edges) into image.pixels,
+// optionally bottom row first. src is the whole decoded image; beyond it and the output, only a row of sums is allocated
+static void storePixels(const unsigned char* src, int width, int height, int channels, int factor, bool flip, DecodedTexture& image)
+{
+    image.width = (width + factor - 1) / factor;
+    image.height = (height + factor - 1) / factor;
+    image.channels = channels;
+    size_t row = (size_t)image.width * channels;
+    image.pixels.resize(row * image.height);
+
+    std::vector<unsigned int> sums(row);
+    for (int y = 0; y < image.height; y++) {
+        unsigned char* dst = &image.pixels[row * (flip ? image.height - 1 - y : y)];
+        if (factor == 1) {
+            std::copy(src + row * y, src + row * (y + 1), dst);
+            continue;
+        }
+
+        std::fill(sums.begin(), sums.end(), 0u);
+        int rows = std::min(factor, height - y * factor);
+        for (int sy = y * factor; sy < y * factor + rows; sy++) {
+            const unsigned char* line = src + (size_t)sy * width * channels;
+            for (int x = 0; x < width; x++)
+                for (int c = 0; c < channels; c++)
+                    sums[(x / factor) * channels + c] += line[x * channels + c];
+        }
+        for (int x = 0; x < image.width; x++) {
+            unsigned int count = rows * std::min(factor, width - x * factor);
+            for (int c = 0; c < channels; c++)
+                dst[x * channels + c] = (unsigned char)((sums[x * channels + c] + count / 2) / count);
+        }
+    }
+}
+
+bool decodeTexture(const std::string& path, TextureVariant variant, DecodedTexture& image, int downsampleTo)
+{
+    image.path = canonicalAssetPath(path);
+    AssetView file;
+    if (!readAsset(image.path, file)) {
+        image.error = "ERROR::ASSETS::FILE_NOT_FOUND: " + path;
+        return false;
+    }
+    int variantId = (int)variant;
+    image.contentHash = hashBytes(&variantId, sizeof(variantId), hashBytes(file.data, file.size));
+
+    // stbi's flip flag is global, so flipping is done here to keep decoding thread safe
+    bool flip = variant == TextureVariant::Flipped;
+    int width, height, channels;
+    unsigned char* pixels = stbi_load_from_memory(file.data, (int)file.size, &width, &height, &channels, flip ? 0 : 3);
+    if (!pixels) {
+        image.error = "ERROR::ASSETS::TEXTURE_DECODE_FAILED: " + path;
+        return false;
+    }
+    if (!flip) channels = 3;
+
+    // stb_image has no scaled decoding: the full image is decoded, then downsampled before anything is uploaded
+    int factor = downsampleFactor(width, height, downsampleTo);
+    if (factor > 1) image.contentHash = hashBytes(&factor, sizeof(factor), image.contentHash);
+    storePixels(pixels, width, height, channels, factor, flip, image);
+    stbi_image_free(pixels);
+    return true;
+}
+
+// --- previews ---
+
+struct TexturePreviewHeader {
+    uint32_t width, height, channels;   // pixels follow, top row first, native channel count
+};
+
+bool encodeTexturePreview(const std::string& path, std::vector<unsigned char>& bytes)
+{
+    AssetView file;
+    if (!readLooseAsset(path, file)) return false;
+    int width, height, channels;
+    unsigned char* pixels = stbi_load_from_memory(file.data, (int)file.size, &width, &height, &channels, 0);
+    if (!pixels) return false;
+
+    int factor = 1;
+    while (std::max(width, height) / factor > TEXTURE_PREVIEW_SIZE) factor *= 2;
+    DecodedTexture preview;
+    storePixels(pixels, width, height, channels, factor, false, preview);
+    stbi_image_free(pixels);
+
+    TexturePreviewHeader header = { (uint32_t)preview.width, (uint32_t)preview.height, (uint32_t)preview.channels };
+    bytes.assign((const unsigned char*)&header, (const unsigned char*)(&header + 1));
+    bytes.insert(bytes.end(), preview.pixels.begin(), preview.pixels.end());
+    return true;
+}
+
+// the packed preview in the variant's layout (RGB for Mipmapped, flipped for Flipped)
+static bool decodeTexturePreview(const AssetView& file, TextureVariant variant, DecodedTexture& image)
+{
+    TexturePreviewHeader header;
+    if (file.size < sizeof(header)) return false;
+    memcpy(&header, file.data, sizeof(header));
+    size_t pixelCount = (size_t)header.width * header.height;
+    if (header.channels < 1 || header.channels > 4 || file.size - sizeof(header) != pixelCount * header.channels) return false;
+
+    const unsigned char* src = file.data + sizeof(header);
+    bool flip = variant == TextureVariant::Flipped;
+    if (flip) {
+        storePixels(src, header.width, header.height, header.channels, 1, true, image);
+        return true;
+    }
+    // as stbi does for a forced 3 channels: gray is replicated, alpha dropped
+    image.width = header.width;
+    image.height = header.height;
+    image.channels = 3;
+    image.pixels.resize(pixelCount * 3);
+    for (size_t i = 0; i < pixelCount; i++)
+        for (int c = 0; c < 3; c++)
+            image.pixels[i * 3 + c] = src[i * header.channels + (header.channels < 3 ? 0 : c)];
+    return true;
+}
+
+// --- upload ---
+
+static void fillTexture(unsigned int texture, const DecodedTexture& image, TextureVariant variant)
+{
+    bool mipmapped = variant == TextureVariant::Mipmapped;
+    GLenum format = GL_RGB;
+    switch (image.channels) {
+    case 1: format = GL_RED; break;
+    case 2: format = GL_RG; break;
+    case 4: format = GL_RGBA; break;
+    default: break;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels.data());
+    if (mipmapped) glGenerateMipmap(GL_TEXTURE_2D);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+static AssetData uploadTexture(const DecodedTexture& image, TextureVariant variant, const std::string& owner)
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    fillTexture(texture, image, variant);
+
+    AssetData data;
+    data.glName = texture;
+    data.bytes = estimateTextureBytes(image.width, image.height, image.channels, variant == TextureVariant::Mipmapped);
+    trackResource(ResourceKind::Texture, texture, data.bytes, owner, image.path);
+    data.unload = [texture]() {
+        glDeleteTextures(1, &texture);
+        untrackResource(ResourceKind::Texture, texture);
+    };
+    return data;
+}
+
+AssetHandle acquireTexture(const DecodedTexture& image, TextureVariant variant, const std::string& owner, int downsampleTo)
+{
+    return acquireAsset(AssetKind::Texture, textureKey(image.path, variant, downsampleTo), image.contentHash,
+                        [&]() { return uploadTexture(image, variant, owner); });
+}
+
+AssetHandle acquireTexture(const std::string& path, TextureVariant variant, const std::string& owner, int downsampleTo)
+{
+    std::string canonical = canonicalAssetPath(path);
+    int slot = findByKey(AssetKind::Texture, textureKey(canonical, variant, downsampleTo));
+    if (slot >= 0) {
+        counters.keyHits++;
+        return AssetHandle(slot);
+    }
+
+    // the file is read once: its bytes are hashed, and uploaded only if the hash is new
+    ScopedAssetTimer timer(canonical);
+    DecodedTexture image;
+    if (!decodeTexture(canonical, variant, image, downsampleTo)) {
+        std::cout << image.error << std::endl;
+        return AssetHandle();
+    }
+    return acquireTexture(image, variant, owner, downsampleTo);
+}
+
+// the full decode of a progressive texture, replacing the preview under the same GL name
+static void refineTexture(const std::string& key, unsigned int texture, const DecodedTexture& image, TextureVariant variant, const std::string& owner)
+{
+    int slot = findByKey(AssetKind::Texture, key);
+    if (slot < 0 || entries[slot].data.glName != texture) return;  // evicted while decoding
+
+    fillTexture(texture, image, variant);
+    AssetEntry& entry = entries[slot];
+    entry.data.bytes = estimateTextureBytes(image.width, image.height, image.channels, variant == TextureVariant::Mipmapped);
+    untrackResource(ResourceKind::Texture, texture);
+    trackResource(ResourceKind::Texture, texture, entry.data.bytes, owner, image.path);
+
+    // the preview had no content hash; now later acquires of a copy can share this texture
+    uint64_t contentKey = kindHash(AssetKind::Texture, image.contentHash);
+    if (!entry.contentHash && !slotByContent.count(contentKey)) {
+        entry.contentHash = image.contentHash;
+        slotByContent[contentKey] = slot;
+    }
+    counters.refinements++;
+    evictOverBudget();
+}
+
+AssetHandle acquireTextureProgressive(const std::string& path, TextureVariant variant, const std::string& owner, int downsampleTo)
+{
+    std::string canonical = canonicalAssetPath(path);
+    std::string key = textureKey(canonical, variant, downsampleTo);
+    int slot = findByKey(AssetKind::Texture, key);
+    if (slot >= 0) {
+        counters.keyHits++;
+        return AssetHandle(slot);
+    }
+
+    // the pack's preview if it has one, else a single gray texel
+    DecodedTexture preview;
+    AssetView file;
+    if (!readAsset(canonical + "#preview", file) || !decodeTexturePreview(file, variant, preview)) {
+        preview.width = preview.height = 1;
+        preview.channels = 3;
+        preview.pixels.assign(3, 128);
+    }
+    preview.path = canonical;
+    AssetHandle handle = acquireAsset(AssetKind::Texture, key, 0, [&]() { return uploadTexture(preview, variant, owner); });
+    if (!handle.valid()) return handle;
+
+    unsigned int texture = handle.id();
+    runInBackground([canonical, key, texture, variant, owner, downsampleTo]() {
+        std::shared_ptr<DecodedTexture> image = std::make_shared<DecodedTexture>();
+        bool decoded = decodeTexture(canonical, variant, *image, downsampleTo);
+        runOnMainThread([key, texture, image, variant, owner, decoded]() {
+            // a failed decode keeps the preview
+            if (decoded) refineTexture(key, texture, *image, variant, owner);
+            else std::cout << image->error << std::endl;
+            return true;
+        });
+    });
+    return handle;
+}
+
+// --- shaders ---
+
+AssetHandle acquireShader(const std::string& vertexPath, const std::string& fragmentPath, const std::vector<std::string>& defines)
+{
+    std::string vertex = canonicalAssetPath(vertexPath), fragment = canonicalAssetPath(fragmentPath);
+    std::vector<std::string> sources;
+    sources.push_back(vertex);
+    sources.push_back(fragment);
+    // the same files with other defines are another program, by key and by content
+    std::string defineList;
+    for (const std::string& define : defines) defineList += "#" + define;
+    uint64_t hash = hashFiles(sources);
+    if (hash && !defineList.empty()) hash = hashBytes(defineList.data(), defineList.size(), hash);
+
+    return acquireAsset(AssetKind::Shader, vertex + "|" + fragment + defineList, hash, [&]() {
+        std::shared_ptr<Shader> shader = std::make_shared<Shader>(vertex.c_str(), fragment.c_str(), defines);
+        AssetData data;
+        data.glName = shader->ID;
+        data.object = shader;
+        // the program may have been swapped by a hot reload since
+        data.unload = [shader]() {
+            shader->discardReload();
+            glDeleteProgram(shader->ID);
+        };
+        return data;
+    });
+}
+
+size_t reloadShaders(const std::vector<std::string>& changedFiles)
+{
+    size_t started = 0;
+    for (AssetEntry& entry : entries) {
+        if (!entry.alive || entry.kind != AssetKind::Shader) continue;
+        Shader& shader = *static_cast<Shader*>(entry.data.object.get());
+        bool changed = false;
+        for (const std::string& file : shader.sourceFiles)
+            changed = changed || std::find(changedFiles.begin(), changedFiles.end(), canonicalAssetPath(file)) != changedFiles.end();
+        if (changed && shader.reload()) started++;
+    }
+    return started;
+}
+
+void pollShaderReloads()
+{
+    for (AssetEntry& entry : entries) {
+        if (!entry.alive || entry.kind != AssetKind::Shader) continue;
+        Shader& shader = *static_cast<Shader*>(entry.data.object.get());
+        if (!shader.pollReload()) continue;
+
+        entry.data.glName = shader.ID;
+        // the sources no longer match the hash they were cached under
+        if (entry.contentHash) slotByContent.erase(kindHash(entry.kind, entry.contentHash));
+        entry.contentHash = 0;
+    }
+}
+
+// --- keys ---
+
+std::string canonicalAssetPath(const std::string& path)
+{
+    std::string normalized = path;
+    std::replace(normalized.begin(), normalized.end(), '\\', '/');
+#ifdef _WIN32
+    // case-insensitive file system
+    std::transform(normalized.begin(), normalized.end(), normalized.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+#endif
+
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= normalized.size()) {
+        size_t end = normalized.find('/', start);
+        if (end == std::string::npos) end = normalized.size();
+        std::string part = normalized.substr(start, end - start);
+        if (part == "..") {
+            if (!parts.empty() && parts.back() != "..") parts.pop_back();
+            else parts.push_back(part);
+        }
+        else if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+        start = end + 1;
+    }
+
+    std::string result = !normalized.empty() && normalized[0] == '/' ? "/" : "";
+    for (size_t i = 0; i < parts.size(); i++) {
+        if (i > 0) result += '/';
+        result += parts[i];
+    }
+    return result;
+}
+
+// 64-bit FNV-1a
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t hashFiles(const std::vector<std::string>& paths)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (const std::string& path : paths) {
+        AssetView bytes;
+        if (!readAsset(path, bytes)) return 0;
+        hash = hashBytes(bytes.data, bytes.size, hash);
+    }
+    return hash;
+}
+
+AssetStats assetStats()
+{
+    AssetStats stats = counters;
+    for (const AssetEntry& entry : entries) {
+        if (!entry.alive) continue;
+        stats.loaded++;
+        if (entry.refs > 0) stats.referenced++;
+        stats.bytes += entry.data.bytes;
+    }
+    return stats;
+}
@@ -0,0 +1,469 @@
+#include "../Header/AssetPack.h"
+#include "../Header/AssetManager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char ASSET_PACK_MAGIC[8] = { 'K', 'O', 'S', 'T', 'P', 'A', 'K', 0 };
+static const uint32_t ASSET_PACK_VERSION = 1;
+static const uint32_t ENTRY_LZ4 = 1;
+
+struct AssetPackHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entryCount;
+    uint64_t indexOffset;       // AssetPackEntry[entryCount]
+    uint64_t pathsOffset;       // path bytes, not terminated
+    uint64_t pathsSize;
+};
+
+struct AssetPackEntry {
+    uint64_t offset;
+    uint64_t storedSize;
+    uint64_t size;              // after decompression
+    uint32_t pathOffset;        // into the path bytes
+    uint32_t pathLength;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(AssetPackHeader) % 8 == 0 && sizeof(AssetPackEntry) % 8 == 0, "pack records must keep 8-byte alignment");
+
+// --- mapping ---
+
+static const unsigned char* mappedData = nullptr;
+static size_t mappedSize = 0;
+static const AssetPackEntry* packEntries = nullptr;
+static const char* packPaths = nullptr;
+static uint32_t packEntryCount = 0;
+
+static std::atomic<size_t> viewCount(0), decompressionCount(0), decompressedBytes(0), looseReadCount(0);
+
+static const unsigned char* mapFile(const std::string& path, size_t& size)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+    LARGE_INTEGER length;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &length) && length.QuadPart > 0)
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) return nullptr;
+    // the view keeps the mapping alive after its handle is closed
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!view) return nullptr;
+    size = (size_t)length.QuadPart;
+    return (const unsigned char*)view;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat info;
+    void* view = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+        view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) return nullptr;
+    size = (size_t)info.st_size;
+    return (const unsigned char*)view;
+#endif
+}
+
+static void unmapFile(const unsigned char* data, size_t size)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+#else
+    munmap((void*)data, size);
+#endif
+}
+
+static bool validPack(const unsigned char* data, size_t size)
+{
+    if (size < sizeof(AssetPackHeader)) return false;
+    const AssetPackHeader& header = *(const AssetPackHeader*)data;
+    if (memcmp(header.magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC)) != 0 || header.version != ASSET_PACK_VERSION) return false;
+    if (header.indexOffset % 8 != 0 || header.indexOffset > size || (size - header.indexOffset) / sizeof(AssetPackEntry) < header.entryCount) return false;
+    if (header.pathsOffset > size || size - header.pathsOffset < header.pathsSize) return false;
+
+    const AssetPackEntry* entries = (const AssetPackEntry*)(data + header.indexOffset);
+    for (uint32_t i = 0; i < header.entryCount; i++) {
+        const AssetPackEntry& entry = entries[i];
+        if (entry.offset > size || size - entry.offset < entry.storedSize) return false;
+        if (entry.pathOffset > header.pathsSize || header.pathsSize - entry.pathOffset < entry.pathLength) return false;
+        if (!(entry.flags & ENTRY_LZ4) && entry.storedSize != entry.size) return false;
+    }
+    return true;
+}
+
+bool openAssetPack(const std::string& path)
+{
+    closeAssetPack();
+    size_t size = 0;
+    const unsigned char* data = mapFile(path, size);
+    if (!data) return false;
+    if (!validPack(data, size)) {
+        std::cout << "ERROR::ASSET_PACK::INVALID: " << path << std::endl;
+        unmapFile(data, size);
+        return false;
+    }
+
+    const AssetPackHeader& header = *(const AssetPackHeader*)data;
+    mappedData = data;
+    mappedSize = size;
+    packEntries = (const AssetPackEntry*)(data + header.indexOffset);
+    packPaths = (const char*)(data + header.pathsOffset);
+    packEntryCount = header.entryCount;
+    std::cout << "Asset pack " << path << ": " << packEntryCount << " entries, " << size / 1024 << " KB mapped" << std::endl;
+    return true;
+}
+
+void closeAssetPack()
+{
+    if (mappedData) unmapFile(mappedData, mappedSize);
+    mappedData = nullptr;
+    mappedSize = 0;
+    packEntries = nullptr;
+    packPaths = nullptr;
+    packEntryCount = 0;
+}
+
+bool isAssetPackOpen()
+{
+    return mappedData != nullptr;
+}
+
+// --- lookup ---
+
+static const AssetPackEntry* findEntry(const std::string& path)
+{
+    if (!mappedData) return nullptr;
+    std::string key = canonicalAssetPath(path);
+    const AssetPackEntry* end = packEntries + packEntryCount;
+    const AssetPackEntry* entry = std::lower_bound(packEntries, end, key, [](const AssetPackEntry& e, const std::string& k) {
+        return k.compare(0, k.size(), packPaths + e.pathOffset, e.pathLength) > 0;
+    });
+    if (entry == end || key.compare(0, key.size(), packPaths + entry->pathOffset, entry->pathLength) != 0) return nullptr;
+    return entry;
+}
+
+static bool lz4Decompress(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstSize);
+
+bool readLooseAsset(const std::string& path, AssetView& view)
+{
+    view = AssetView();
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::shared_ptr<std::vector<unsigned char>> bytes = std::make_shared<std::vector<unsigned char>>(
+        std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    looseReadCount++;
+    view.owned = bytes;
+    view.data = bytes->empty() ? (const unsigned char*)"" : bytes->data();
+    view.size = bytes->size();
+    view.mapped = false;
+    return true;
+}
+
+bool readAsset(const std::string& path, AssetView& view)
+{
+    view = AssetView();
+    const AssetPackEntry* entry = findEntry(path);
+    if (!entry) return readLooseAsset(path, view);
+
+    const unsigned char* stored = mappedData + entry->offset;
+    if (!(entry->flags & ENTRY_LZ4)) {
+        viewCount++;
+        view.data = stored;
+        view.size = (size_t)entry->size;
+        view.mapped = true;
+        return true;
+    }
+
+    std::shared_ptr<std::vector<unsigned char>> bytes = std::make_shared<std::vector<unsigned char>>((size_t)entry->size);
+    if (!lz4Decompress(stored, (size_t)entry->storedSize, bytes->data(), bytes->size())) {
+        std::cout << "ERROR::ASSET_PACK::CORRUPT_ENTRY: " << path << std::endl;
+        return readLooseAsset(path, view);
+    }
+    decompressionCount++;
+    decompressedBytes += bytes->size();
+    view.owned = bytes;
+    view.data = bytes->empty() ? (const unsigned char*)"" : bytes->data();
+    view.size = bytes->size();
+    return true;
+}
+
+bool assetExists(const std::string& path)
+{
+    if (findEntry(path)) return true;
+    std::ifstream file(path, std::ios::binary);
+    return (bool)file;
+}
+
+AssetPackStats assetPackStats()
+{
+    AssetPackStats stats;
+    stats.entries = packEntryCount;
+    stats.mappedBytes = mappedSize;
+    stats.views = viewCount.load();
+    stats.decompressions = decompressionCount.load();
+    stats.decompressedBytes = decompressedBytes.load();
+    stats.looseReads = looseReadCount.load();
+    return stats;
+}
+
+// --- LZ4 block format ---
+// sequences of [token][literal length+][literals][offset, 2 bytes][match length+]; the last
+// sequence is literals only. Matches are at least 4 bytes, the last 5 bytes are always
+// literals and the last match starts at least 12 bytes before the end
+
+static const size_t LZ4_MIN_MATCH = 4;
+static const size_t LZ4_LAST_LITERALS = 5;
+static const size_t LZ4_MATCH_START_LIMIT = 12;
+static const int LZ4_HASH_BITS = 16;
+
+static uint32_t read32(const unsigned char* p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static void writeLength(std::vector<unsigned char>& out, size_t length)
+{
+    for (; length >= 255; length -= 255) out.push_back(255);
+    out.push_back((unsigned char)length);
+}
+
+static bool readLength(const unsigned char*& ip, const unsigned char* end, size_t& length)
+{
+    unsigned char byte;
+    do {
+        if (ip >= end) return false;
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// greedy single-probe hash matcher: a fraction of the reference encoder's speed, but pack
+// building is offline and decompression is what runs at startup
+static std::vector<unsigned char> lz4Compress(const unsigned char* src, size_t size)
+{
+    std::vector<unsigned char> out;
+    out.reserve(size / 2 + 16);
+    std::vector<uint32_t> table((size_t)1 << LZ4_HASH_BITS, UINT32_MAX);
+
+    size_t anchor = 0, pos = 0;
+    while (size >= LZ4_MATCH_START_LIMIT && pos <= size - LZ4_MATCH_START_LIMIT) {
+        uint32_t sequence = read32(src + pos);
+        uint32_t hash = (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+        uint32_t candidate = table[hash];
+        table[hash] = (uint32_t)pos;
+        if (candidate == UINT32_MAX || pos - candidate > 65535 || read32(src + candidate) != sequence) {
+            pos++;
+            continue;
+        }
+
+        size_t length = LZ4_MIN_MATCH;
+        while (pos + length < size - LZ4_LAST_LITERALS && src[candidate + length] == src[pos + length]) length++;
+
+        size_t literals = pos - anchor, extra = length - LZ4_MIN_MATCH, offset = pos - candidate;
+        out.push_back((unsigned char)((std::min<size_t>(literals, 15) << 4) | std::min<size_t>(extra, 15)));
+        if (literals >= 15) writeLength(out, literals - 15);
+        out.insert(out.end(), src + anchor, src + pos);
+        out.push_back((unsigned char)(offset & 255));
+        out.push_back((unsigned char)(offset >> 8));
+        if (extra >= 15) writeLength(out, extra - 15);
+
+        pos += length;
+        anchor = pos;
+    }
+
+    size_t literals = size - anchor;
+    out.push_back((unsigned char)(std::min<size_t>(literals, 15) << 4));
+    if (literals >= 15) writeLength(out, literals - 15);
+    out.insert(out.end(), src + anchor, src + size);
+    return out;
+}
+
+static bool lz4Decompress(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstSize)
+{
+    const unsigned char* ip = src;
+    const unsigned char* inEnd = src + srcSize;
+    unsigned char* op = dst;
+    unsigned char* outEnd = dst + dstSize;
+
+    while (ip < inEnd) {
+        unsigned char token = *ip++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !readLength(ip, inEnd, literals)) return false;
+        if ((size_t)(inEnd - ip) < literals || (size_t)(outEnd - op) < literals) return false;
+        memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+        if (ip == inEnd) break;     // last sequence: literals only
+
+        if (inEnd - ip < 2) return false;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) return false;
+        size_t length = token & 15;
+        if (length == 15 && !readLength(ip, inEnd, length)) return false;
+        length += LZ4_MIN_MATCH;
+        if ((size_t)(outEnd - op) < length) return false;
+
+        // byte by byte: the match may overlap what it is writing
+        const unsigned char* match = op - offset;
+        for (size_t i = 0; i < length; i++) op[i] = match[i];
+        op += length;
+    }
+    return op == outEnd;
+}
+
+// --- packing ---
+
+static void listFiles(const std::string& directory, std::vector<std::string>& files)
+{
+#ifdef _WIN32
+    WIN32_FIND_DATAA found;
+    HANDLE search = FindFirstFileA((directory + "/*").c_str(), &found);
+    if (search == INVALID_HANDLE_VALUE) return;
+    do {
+        std::string name = found.cFileName;
+        if (name == "." || name == "..") continue;
+        if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) listFiles(directory + "/" + name, files);
+        else files.push_back(directory + "/" + name);
+    } while (FindNextFileA(search, &found));
+    FindClose(search);
+#else
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) return;
+    while (dirent* found = readdir(dir)) {
+        std::string name = found->d_name;
+        if (name == "." || name == "..") continue;
+        struct stat info;
+        if (stat((directory + "/" + name).c_str(), &info) != 0) continue;
+        if (S_ISDIR(info.st_mode)) listFiles(directory + "/" + name, files);
+        else files.push_back(directory + "/" + name);
+    }
+    closedir(dir);
+#endif
+}
+
+static void padTo(std::ofstream& out, uint64_t& position, uint64_t alignment)
+{
+    static const char zeros[ASSET_PACK_ALIGNMENT] = {};
+    uint64_t padding = (alignment - position % alignment) % alignment;
+    out.write(zeros, (std::streamsize)padding);
+    position += padding;
+}
+
+bool buildAssetPack(const std::string& outputPath, const std::vector<std::string>& roots, bool compress)
+{
+    std::vector<std::string> files;
+    for (const std::string& root : roots) listFiles(root, files);
+
+    // the index is binary searched, so entries go in canonical path order. Images also get a small
+    // "#preview" entry, shown by progressive textures until their full decode is done
+    std::vector<std::pair<std::string, std::string>> sorted;
+    for (const std::string& file : files) {
+        std::string key = canonicalAssetPath(file);
+        sorted.push_back(std::make_pair(key, file));
+        size_t dot = key.find_last_of('.');
+        std::string extension = dot == std::string::npos ? "" : key.substr(dot);
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+        if (extension == ".png" || extension == ".jpg" || extension == ".jpeg")
+            sorted.push_back(std::make_pair(key + "#preview", file));
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    std::ofstream out(outputPath, std::ios::binary);
+    if (!out) {
+        std::cout << "ERROR::ASSET_PACK::CANNOT_WRITE: " << outputPath << std::endl;
+        return false;
+    }
+    AssetPackHeader header = {};
+    memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC));
+    header.version = ASSET_PACK_VERSION;
+    out.write((const char*)&header, sizeof(header));
+    uint64_t position = sizeof(header);
+
+    std::vector<AssetPackEntry> entries;
+    std::string paths;
+    uint64_t originalBytes = 0;
+    for (size_t i = 0; i < sorted.size(); i++) {
+        if (i > 0 && sorted[i].first == sorted[i - 1].first) continue;
+        std::vector<unsigned char> bytes;
+        bool preview = sorted[i].first.size() > 8 && sorted[i].first.compare(sorted[i].first.size() - 8, 8, "#preview") == 0;
+        if (preview) {
+            if (!encodeTexturePreview(sorted[i].second, bytes)) continue;
+        }
+        else {
+            std::ifstream file(sorted[i].second, std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        AssetPackEntry entry = {};
+        entry.size = bytes.size();
+        entry.pathOffset = (uint32_t)paths.size();
+        entry.pathLength = (uint32_t)sorted[i].first.size();
+        paths += sorted[i].first;
+
+        // images are already compressed; text (OBJ, MTL, shaders) usually halves
+        std::vector<unsigned char> packed;
+        if (compress && !bytes.empty()) packed = lz4Compress(bytes.data(), bytes.size());
+        if (!packed.empty() && packed.size() <= bytes.size() - bytes.size() / 8) {
+            entry.flags = ENTRY_LZ4;
+            bytes.swap(packed);
+        }
+
+        padTo(out, position, ASSET_PACK_ALIGNMENT);
+        entry.offset = position;
+        entry.storedSize = bytes.size();
+        out.write((const char*)bytes.data(), (std::streamsize)bytes.size());
+        position += bytes.size();
+        originalBytes += entry.size;
+        entries.push_back(entry);
+    }
+
+    padTo(out, position, ASSET_PACK_ALIGNMENT);
+    header.entryCount = (uint32_t)entries.size();
+    header.indexOffset = position;
+    out.write((const char*)entries.data(), (std::streamsize)(entries.size() * sizeof(AssetPackEntry)));
+    position += entries.size() * sizeof(AssetPackEntry);
+    header.pathsOffset = position;
+    header.pathsSize = paths.size();
+    out.write(paths.data(), (std::streamsize)paths.size());
+    position += paths.size();
+
+    out.seekp(0);
+    out.write((const char*)&header, sizeof(header));
+    if (!out) {
+        std::cout << "ERROR::ASSET_PACK::CANNOT_WRITE: " << outputPath << std::endl;
+        return false;
+    }
+
+    size_t compressed = (size_t)std::count_if(entries.begin(), entries.end(), [](const AssetPackEntry& e) { return (e.flags & ENTRY_LZ4) != 0; });
+    std::cout << "Packed " << entries.size() << " files (" << compressed << " LZ4) into " << outputPath << ": "
+              << originalBytes / 1024 << " KB -> " << position / 1024 << " KB" << std::endl;
+    return true;
+}
@@ -0,0 +1,132 @@
+#include "../Header/BackgroundLoader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static std::vector<std::thread> workers;
+static std::deque<std::function<void()>> jobs;
+static std::deque<std::function<bool()>> steps;
+static std::mutex jobMutex, stepMutex;
+static std::condition_variable jobAvailable;
+static bool stopping = false;
+static size_t runningJobs = 0;
+static double lastWorkMs = 0.0;
+
+static void workerLoop()
+{
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobAvailable.wait(lock, [] { return stopping || !jobs.empty(); });
+            if (stopping) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            runningJobs++;
+        }
+        job();
+        std::lock_guard<std::mutex> lock(jobMutex);
+        runningJobs--;
+    }
+}
+
+void startBackgroundLoader(unsigned int workerCount)
+{
+    if (!workers.empty()) return;
+    if (workerCount == 0) {
+        // one core left for the main thread; hardware_concurrency may be 0 when unknown
+        unsigned int cores = std::thread::hardware_concurrency();
+        workerCount = cores > 1 ? cores - 1 : 1;
+    }
+
+    stopping = false;
+    for (unsigned int i = 0; i < workerCount; i++)
+        workers.push_back(std::thread(workerLoop));
+}
+
+void stopBackgroundLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+        jobs.clear();
+    }
+    jobAvailable.notify_all();
+    for (std::thread& worker : workers) worker.join();
+    workers.clear();
+
+    std::lock_guard<std::mutex> lock(stepMutex);
+    steps.clear();
+}
+
+void runInBackground(const std::function<void()>& job)
+{
+    if (workers.empty()) {
+        job();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobs.push_back(job);
+    }
+    jobAvailable.notify_one();
+}
+
+void runOnMainThread(const std::function<bool()>& step)
+{
+    std::lock_guard<std::mutex> lock(stepMutex);
+    steps.push_back(step);
+}
+
+size_t processMainThreadWork(double budgetMs)
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    size_t ran = 0;
+
+    for (;;) {
+        std::function<bool()> step;
+        {
+            std::lock_guard<std::mutex> lock(stepMutex);
+            if (steps.empty()) break;
+            step = std::move(steps.front());
+            steps.pop_front();
+        }
+
+        // unfinished steps go back to the front so a model finishes before the next one starts
+        // (steps may queue new steps while running, hence no lock here)
+        bool done = step();
+        ran++;
+        if (!done) {
+            std::lock_guard<std::mutex> lock(stepMutex);
+            steps.push_front(std::move(step));
+        }
+
+        if (std::chrono::duration<double, std::milli>(Clock::now() - start).count() >= budgetMs) break;
+    }
+
+    lastWorkMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return ran;
+}
+
+BackgroundLoaderStats backgroundLoaderStats()
+{
+    BackgroundLoaderStats stats;
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stats.workers = workers.size();
+        stats.queuedJobs = jobs.size();
+        stats.runningJobs = runningJobs;
+    }
+    {
+        std::lock_guard<std::mutex> lock(stepMutex);
+        stats.pendingSteps = steps.size();
+    }
+    stats.lastWorkMs = lastWorkMs;
+    return stats;
+}
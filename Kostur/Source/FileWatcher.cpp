@@ -0,0 +1,185 @@
+#include "../Header/FileWatcher.h"
+#include "../Header/AssetManager.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// how long the watcher thread blocks before checking whether it should stop
+static const int WATCH_WAKE_MS = 100;
+
+static std::thread watcher;
+static std::atomic<bool> watching(false);
+static std::mutex changedMutex;
+static std::set<std::string> changedFiles;
+
+static void reportChange(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(changedMutex);
+    changedFiles.insert(canonicalAssetPath(path));
+}
+
+#ifdef _WIN32
+
+static HANDLE watchedDirectory = INVALID_HANDLE_VALUE;
+
+static void watchLoop(std::string root)
+{
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+    DWORD buffer[16 * 1024];
+    const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+
+    bool issued = false;
+    while (watching.load()) {
+        if (!issued) {
+            ResetEvent(overlapped.hEvent);
+            if (!ReadDirectoryChangesW(watchedDirectory, buffer, sizeof(buffer), TRUE, filter, NULL, &overlapped, NULL)) break;
+            issued = true;
+        }
+        if (WaitForSingleObject(overlapped.hEvent, WATCH_WAKE_MS) != WAIT_OBJECT_0) continue;
+
+        DWORD bytes = 0;
+        issued = false;
+        if (!GetOverlappedResult(watchedDirectory, &overlapped, &bytes, FALSE) || bytes == 0) continue;  // 0: buffer overflowed
+
+        const unsigned char* record = (const unsigned char*)buffer;
+        for (;;) {
+            const FILE_NOTIFY_INFORMATION& info = *(const FILE_NOTIFY_INFORMATION*)record;
+            if (info.Action != FILE_ACTION_REMOVED && info.Action != FILE_ACTION_RENAMED_OLD_NAME) {
+                int wideLength = (int)(info.FileNameLength / sizeof(WCHAR));
+                int length = WideCharToMultiByte(CP_UTF8, 0, info.FileName, wideLength, NULL, 0, NULL, NULL);
+                std::string name(length, '\0');
+                WideCharToMultiByte(CP_UTF8, 0, info.FileName, wideLength, &name[0], length, NULL, NULL);
+                reportChange(root + "/" + name);
+            }
+            if (!info.NextEntryOffset) break;
+            record += info.NextEntryOffset;
+        }
+    }
+
+    CancelIo(watchedDirectory);
+    if (issued) {
+        DWORD bytes;
+        GetOverlappedResult(watchedDirectory, &overlapped, &bytes, TRUE);
+    }
+    CloseHandle(overlapped.hEvent);
+}
+
+bool startFileWatcher(const std::string& directory)
+{
+    if (watching.load()) return true;
+    watchedDirectory = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                   NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (watchedDirectory == INVALID_HANDLE_VALUE) return false;
+
+    watching.store(true);
+    watcher = std::thread(watchLoop, directory);
+    return true;
+}
+
+void stopFileWatcher()
+{
+    if (!watching.load()) return;
+    watching.store(false);
+    watcher.join();
+    CloseHandle(watchedDirectory);
+    watchedDirectory = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+static int inotifyFd = -1;
+static std::map<int, std::string> watchedDirectories;  // watch descriptor -> directory
+
+// inotify isn't recursive: every directory of the tree gets its own watch
+static void addWatches(const std::string& directory)
+{
+    int wd = inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (wd < 0) return;
+    watchedDirectories[wd] = directory;
+
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) return;
+    while (dirent* found = readdir(dir)) {
+        std::string name = found->d_name;
+        struct stat info;
+        if (name != "." && name != ".." && stat((directory + "/" + name).c_str(), &info) == 0 && S_ISDIR(info.st_mode))
+            addWatches(directory + "/" + name);
+    }
+    closedir(dir);
+}
+
+static void watchLoop()
+{
+    alignas(inotify_event) char buffer[16 * 1024];
+    while (watching.load()) {
+        pollfd descriptor = { inotifyFd, POLLIN, 0 };
+        if (poll(&descriptor, 1, WATCH_WAKE_MS) <= 0) continue;
+
+        ssize_t bytes = read(inotifyFd, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < bytes; ) {
+            const inotify_event& event = *(const inotify_event*)(buffer + offset);
+            offset += sizeof(inotify_event) + event.len;
+            // IN_CREATE only matters for new directories; a new file is reported by its IN_CLOSE_WRITE
+            if (event.len == 0 || ((event.mask & IN_CREATE) && !(event.mask & IN_ISDIR))) continue;
+
+            std::map<int, std::string>::const_iterator dir = watchedDirectories.find(event.wd);
+            if (dir == watchedDirectories.end()) continue;
+            std::string path = dir->second + "/" + event.name;
+            if (event.mask & IN_ISDIR) addWatches(path);
+            else reportChange(path);
+        }
+    }
+}
+
+bool startFileWatcher(const std::string& directory)
+{
+    if (watching.load()) return true;
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) return false;
+    addWatches(directory);
+    if (watchedDirectories.empty()) {
+        close(inotifyFd);
+        inotifyFd = -1;
+        return false;
+    }
+
+    watching.store(true);
+    watcher = std::thread(watchLoop);
+    return true;
+}
+
+void stopFileWatcher()
+{
+    if (!watching.load()) return;
+    watching.store(false);
+    watcher.join();
+    close(inotifyFd);   // drops every watch with it
+    inotifyFd = -1;
+    watchedDirectories.clear();
+}
+
+#endif
+
+std::vector<std::string> takeChangedFiles()
+{
+    std::lock_guard<std::mutex> lock(changedMutex);
+    std::vector<std::string> files(changedFiles.begin(), changedFiles.end());
+    changedFiles.clear();
+    return files;
+}
@@ -0,0 +1,182 @@
+#include "../Header/GeometryPool.h"
+#include "../Header/ResourceRegistry.h"
+
+#include <algorithm>
+#include <iostream>
+
+static std::vector<const GeometryPool*> pools;
+
+const std::vector<const GeometryPool*>& geometryPools()
+{
+    return pools;
+}
+
+GeometryPool::GeometryPool(const std::string& name, GLsizei vertexStride, const std::vector<VertexAttribute>& attributes, GLenum indexType,
+                           size_t initialVertices, size_t initialIndices)
+    : poolName(name), stride(vertexStride), poolIndexType(indexType), indexBytes(indexSize(indexType)), attributes(attributes)
+{
+    poolStats.vertexCapacity = initialVertices;
+    poolStats.indexCapacity = initialIndices;
+    pools.push_back(this);
+}
+
+void GeometryPool::create()
+{
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, poolStats.vertexCapacity * stride, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, poolStats.indexCapacity * indexBytes, nullptr, GL_STATIC_DRAW);
+    applyVertexAttributes(stride, attributes);
+    glBindVertexArray(0);
+
+    freeVertices.push_back({ 0, poolStats.vertexCapacity });
+    freeIndices.push_back({ 0, poolStats.indexCapacity });
+
+    trackResource(ResourceKind::VertexArray, VAO, 0, "GeometryPool", poolName);
+    trackResource(ResourceKind::Buffer, VBO, poolStats.vertexCapacity * stride, "GeometryPool", poolName);
+    trackResource(ResourceKind::Buffer, EBO, poolStats.indexCapacity * indexBytes, "GeometryPool", poolName);
+}
+
+bool GeometryPool::takeBlock(std::vector<Block>& freeList, size_t size, size_t& offset)
+{
+    for (size_t i = 0; i < freeList.size(); i++) {
+        if (freeList[i].size < size) continue;
+        offset = freeList[i].offset;
+        freeList[i].offset += size;
+        freeList[i].size -= size;
+        if (freeList[i].size == 0) freeList.erase(freeList.begin() + i);
+        return true;
+    }
+    return false;
+}
+
+void GeometryPool::giveBlock(std::vector<Block>& freeList, size_t offset, size_t size)
+{
+    // the list is kept sorted by offset so neighbours can be merged
+    auto it = std::lower_bound(freeList.begin(), freeList.end(), offset, [](const Block& b, size_t o) { return b.offset < o; });
+    it = freeList.insert(it, { offset, size });
+
+    auto next = it + 1;
+    if (next != freeList.end() && it->offset + it->size == next->offset) {
+        it->size += next->size;
+        freeList.erase(next);
+    }
+    if (it != freeList.begin()) {
+        auto prev = it - 1;
+        if (prev->offset + prev->size == it->offset) {
+            prev->size += it->size;
+            freeList.erase(it);
+        }
+    }
+}
+
+void GeometryPool::growVertices(size_t minimumFree)
+{
+    size_t oldCapacity = poolStats.vertexCapacity;
+    size_t newCapacity = oldCapacity * 2;
+    while (newCapacity - oldCapacity < minimumFree) newCapacity *= 2;
+
+    unsigned int newVBO;
+    glGenBuffers(1, &newVBO);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newVBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, newCapacity * stride, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, VBO);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldCapacity * stride);
+    glDeleteBuffers(1, &VBO);
+    untrackResource(ResourceKind::Buffer, VBO);
+    VBO = newVBO;
+
+    // attribute pointers capture the buffer, so they have to be re-specified
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    applyVertexAttributes(stride, attributes);
+    glBindVertexArray(0);
+
+    giveBlock(freeVertices, oldCapacity, newCapacity - oldCapacity);
+    poolStats.vertexCapacity = newCapacity;
+    poolStats.growths++;
+    trackResource(ResourceKind::Buffer, VBO, newCapacity * stride, "GeometryPool", poolName);
+}
+
+void GeometryPool::growIndices(size_t minimumFree)
+{
+    size_t oldCapacity = poolStats.indexCapacity;
+    size_t newCapacity = oldCapacity * 2;
+    while (newCapacity - oldCapacity < minimumFree) newCapacity *= 2;
+
+    unsigned int newEBO;
+    glGenBuffers(1, &newEBO);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newEBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, newCapacity * indexBytes, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, EBO);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldCapacity * indexBytes);
+    glDeleteBuffers(1, &EBO);
+    untrackResource(ResourceKind::Buffer, EBO);
+    EBO = newEBO;
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBindVertexArray(0);
+
+    giveBlock(freeIndices, oldCapacity, newCapacity - oldCapacity);
+    poolStats.indexCapacity = newCapacity;
+    poolStats.growths++;
+    trackResource(ResourceKind::Buffer, EBO, newCapacity * indexBytes, "GeometryPool", poolName);
+}
+
+GeometryRange GeometryPool::allocate(const void* vertices, size_t vertexCount, const void* indices, size_t indexCount)
+{
+    GeometryRange range;
+    if (vertexCount == 0 || indexCount == 0) return range;
+    if (VAO == 0) create();
+
+    size_t vertexOffset, indexOffset;
+    if (!takeBlock(freeVertices, vertexCount, vertexOffset)) {
+        growVertices(vertexCount);
+        takeBlock(freeVertices, vertexCount, vertexOffset);
+    }
+    if (!takeBlock(freeIndices, indexCount, indexOffset)) {
+        growIndices(indexCount);
+        takeBlock(freeIndices, indexCount, indexOffset);
+    }
+
+    // uploads go through the copy target so whichever VAO is bound keeps its element buffer
+    glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, vertexOffset * stride, vertexCount * stride, vertices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset * indexBytes, indexCount * indexBytes, indices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    range.baseVertex = (GLint)vertexOffset;
+    range.vertexCount = (GLsizei)vertexCount;
+    range.firstIndex = (GLsizei)indexOffset;
+    range.indexCount = (GLsizei)indexCount;
+
+    poolStats.vertexUsed += vertexCount;
+    poolStats.indexUsed += indexCount;
+    poolStats.allocations++;
+    poolStats.freeBlocks = (unsigned int)(freeVertices.size() + freeIndices.size());
+    return range;
+}
+
+void GeometryPool::release(const GeometryRange& range)
+{
+    if (!range.valid()) return;
+    if (VAO == 0) {
+        std::cout << "ERROR::GEOMETRY_POOL::RELEASE_WITHOUT_ALLOCATION " << poolName << std::endl;
+        return;
+    }
+
+    giveBlock(freeVertices, range.baseVertex, range.vertexCount);
+    giveBlock(freeIndices, range.firstIndex, range.indexCount);
+
+    poolStats.vertexUsed -= range.vertexCount;
+    poolStats.indexUsed -= range.indexCount;
+    poolStats.allocations--;
+    poolStats.freeBlocks = (unsigned int)(freeVertices.size() + freeIndices.size());
+}
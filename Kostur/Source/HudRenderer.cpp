@@ -0,0 +1,211 @@
+#include "../Header/HudRenderer.h"
+#include "../Header/TextUtil.h"
+#include "../Header/ResourceRegistry.h"
+#include "../Header/shader.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <GL/glew.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+void HudRenderer::init(float screenWidth, float screenHeight)
+{
+    shaderAsset = acquireShader("Shaders/hud.vert", "Shaders/hud.frag");
+    projection = glm::ortho(0.0f, screenWidth, 0.0f, screenHeight);
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(HudVertex), (void*)offsetof(HudVertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(HudVertex), (void*)offsetof(HudVertex, uv));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(HudVertex), (void*)offsetof(HudVertex, color));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    trackResource(ResourceKind::VertexArray, vao, 0, "UI");
+    trackResource(ResourceKind::Buffer, vbo, 0, "UI");
+}
+
+void HudRenderer::release()
+{
+    if (!vao) return;
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    untrackResource(ResourceKind::VertexArray, vao);
+    untrackResource(ResourceKind::Buffer, vbo);
+    vao = vbo = 0;
+    vboBytes = 0;
+    shaderAsset.reset();
+    elements.clear();
+    vertices.clear();
+    batches.clear();
+    dirty = true;
+}
+
+int HudRenderer::addSprite(unsigned int texture, float x, float y, float width, float height, const glm::vec4& color)
+{
+    Element sprite;
+    sprite.texture = texture;
+    sprite.x = x;
+    sprite.y = y;
+    sprite.width = width;
+    sprite.height = height;
+    sprite.color = color;
+    elements.push_back(sprite);
+    dirty = true;
+    return (int)elements.size() - 1;
+}
+
+int HudRenderer::addText(const std::string& text, float x, float y, float scale, const glm::vec4& color)
+{
+    Element label;
+    label.isText = true;
+    label.texture = textAtlas();
+    label.x = x;
+    label.y = y;
+    label.scale = scale;
+    label.color = color;
+    label.text = text;
+    elements.push_back(label);
+    dirty = true;
+    return (int)elements.size() - 1;
+}
+
+void HudRenderer::setSpriteTexture(int sprite, unsigned int texture)
+{
+    Element& element = elements[sprite];
+    if (element.texture == texture) return;
+    element.texture = texture;
+    dirty = true;
+}
+
+void HudRenderer::setText(int text, const std::string& value)
+{
+    Element& element = elements[text];
+    element.numberDecimals = -1;
+    if (element.text == value) return;
+    element.text = value;
+    dirty = true;
+}
+
+void HudRenderer::setNumber(int text, const std::string& prefix, double value, int decimals)
+{
+    Element& element = elements[text];
+    // the value as an integer count of its last printed digit: equal counts print the same
+    long long digits = std::llround(value * std::pow(10.0, decimals));
+    if (element.numberDecimals == decimals && element.numberDigits == digits && element.numberPrefix == prefix) return;
+
+    char number[64];
+    std::snprintf(number, sizeof(number), "%.*f", decimals, digits / std::pow(10.0, decimals));
+    element.text = prefix + number;
+    element.numberPrefix = prefix;
+    element.numberDigits = digits;
+    element.numberDecimals = decimals;
+    dirty = true;
+}
+
+void HudRenderer::appendQuad(float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, const glm::vec4& color)
+{
+    HudVertex corners[4];
+    const float positions[4][4] = {
+        { x0, y1, u0, v0 },     // top left; textures are top row first
+        { x0, y0, u0, v1 },
+        { x1, y0, u1, v1 },
+        { x1, y1, u1, v0 }
+    };
+    for (int i = 0; i < 4; i++) {
+        corners[i].position = glm::vec2(positions[i][0], positions[i][1]);
+        corners[i].uv = glm::vec2(positions[i][2], positions[i][3]);
+        for (int c = 0; c < 4; c++)
+            corners[i].color[c] = (unsigned char)(glm::clamp(color[c], 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+    const int order[6] = { 0, 1, 2, 0, 2, 3 };
+    for (int i : order)
+        vertices.push_back(corners[i]);
+}
+
+void HudRenderer::rebuild()
+{
+    vertices.clear();
+    batches.clear();
+
+    // textures in the order they first appear, then every element of each in turn
+    std::vector<unsigned int> textures;
+    for (const Element& element : elements)
+        if (element.texture && std::find(textures.begin(), textures.end(), element.texture) == textures.end())
+            textures.push_back(element.texture);
+
+    std::vector<GlyphQuad> glyphs;
+    for (unsigned int texture : textures) {
+        Batch batch = { texture, (int)vertices.size(), 0 };
+        for (const Element& element : elements) {
+            if (element.texture != texture) continue;
+            if (!element.isText) {
+                appendQuad(element.x, element.y, element.x + element.width, element.y + element.height, 0.0f, 0.0f, 1.0f, 1.0f, element.color);
+                continue;
+            }
+            glyphs.clear();
+            layoutText(element.text, element.x, element.y, element.scale, glyphs);
+            for (const GlyphQuad& q : glyphs)
+                appendQuad(q.x0, q.y0, q.x1, q.y1, q.u0, q.v0, q.u1, q.v1, element.color);
+        }
+        batch.count = (int)vertices.size() - batch.first;
+        if (batch.count > 0) batches.push_back(batch);
+    }
+
+    size_t bytes = vertices.size() * sizeof(HudVertex);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (bytes > vboBytes) {
+        vboBytes = bytes;
+        glBufferData(GL_ARRAY_BUFFER, bytes, vertices.data(), GL_DYNAMIC_DRAW);
+        trackResource(ResourceKind::Buffer, vbo, bytes, "UI");
+    }
+    else if (bytes > 0) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, vertices.data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    hudStats.elements = elements.size();
+    hudStats.vertices = vertices.size();
+    hudStats.rebuilds++;
+    dirty = false;
+}
+
+void HudRenderer::draw()
+{
+    hudStats.drawCalls = 0;
+    if (!vao) return;
+    if (dirty) rebuild();
+    if (batches.empty()) return;
+
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // set on every draw: a hot reload replaces the program
+    Shader& shader = *shaderAsset.get<Shader>();
+    shader.use();
+    shader.setMat4("uProjection", projection);
+    shader.setInt("uTexture", 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(vao);
+    for (const Batch& batch : batches) {
+        glBindTexture(GL_TEXTURE_2D, batch.texture);
+        glDrawArrays(GL_TRIANGLES, batch.first, batch.count);
+        hudStats.drawCalls++;
+    }
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (depthTest) glEnable(GL_DEPTH_TEST);
+    if (cullFace) glEnable(GL_CULL_FACE);
+}
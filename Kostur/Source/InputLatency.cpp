@@ -0,0 +1,116 @@
+#include "../Header/InputLatency.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+struct PendingInput {
+    InputEventType type;
+    double timestamp;
+    uint64_t sequence;
+};
+
+static std::vector<PendingInput> pendingInputs;   // arrived, not yet seen by a frame
+static std::vector<PendingInput> frameInputs;     // consumed by the frame currently being built
+static std::vector<double> keySamples;            // latencies in milliseconds
+static std::vector<double> mouseSamples;
+static uint64_t nextSequence = 1;
+
+const size_t MAX_LATENCY_SAMPLES = 100000;
+
+uint64_t onInputEvent(InputEventType type, double timestamp)
+{
+    pendingInputs.push_back({ type, timestamp, nextSequence });
+    return nextSequence++;
+}
+
+uint64_t latestInputSequence()
+{
+    return nextSequence - 1;
+}
+
+void beginInputFrame(uint64_t appliedSequence)
+{
+    // pending inputs are in sequence order
+    size_t consumed = 0;
+    while (consumed < pendingInputs.size() && pendingInputs[consumed].sequence <= appliedSequence) consumed++;
+    frameInputs.insert(frameInputs.end(), pendingInputs.begin(), pendingInputs.begin() + consumed);
+    pendingInputs.erase(pendingInputs.begin(), pendingInputs.begin() + consumed);
+}
+
+void onFramePresented(double timestamp)
+{
+    for (const PendingInput& input : frameInputs) {
+        std::vector<double>& samples = input.type == InputEventType::Key ? keySamples : mouseSamples;
+        if (samples.size() < MAX_LATENCY_SAMPLES)
+            samples.push_back((timestamp - input.timestamp) * 1000.0);
+    }
+    frameInputs.clear();
+}
+
+void resetInputLatency()
+{
+    pendingInputs.clear();
+    frameInputs.clear();
+    keySamples.clear();
+    mouseSamples.clear();
+}
+
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty()) return 0.0;
+    size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+static std::string describeSamples(const char* name, std::vector<double> samples)
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2) << name << ": ";
+    if (samples.empty()) {
+        ss << "no samples";
+        return ss.str();
+    }
+    std::sort(samples.begin(), samples.end());
+    ss << samples.size() << " events, p50 " << percentile(samples, 0.50)
+       << " ms, p90 " << percentile(samples, 0.90)
+       << " ms, p99 " << percentile(samples, 0.99)
+       << " ms, max " << samples.back() << " ms";
+    return ss.str();
+}
+
+std::string inputLatencySummary()
+{
+    std::vector<double> all = keySamples;
+    all.insert(all.end(), mouseSamples.begin(), mouseSamples.end());
+    return describeSamples("Input latency", all);
+}
+
+void printInputLatencyReport(const std::string& configuration)
+{
+    std::cout << "--- Input-to-present latency (" << configuration << ") ---" << std::endl;
+    std::cout << "  " << describeSamples("keys ", keySamples) << std::endl;
+    std::cout << "  " << describeSamples("mouse", mouseSamples) << std::endl;
+
+    // Coarse histogram over all events, 4 ms buckets
+    std::vector<double> all = keySamples;
+    all.insert(all.end(), mouseSamples.begin(), mouseSamples.end());
+    if (all.empty()) return;
+
+    const int bucketMs = 4;
+    const int bucketCount = 16;
+    int buckets[bucketCount + 1] = { 0 };
+    for (double ms : all)
+        buckets[std::min((int)(ms / bucketMs), bucketCount)]++;
+
+    for (int i = 0; i <= bucketCount; i++) {
+        if (buckets[i] == 0) continue;
+        std::stringstream range;
+        if (i < bucketCount) range << i * bucketMs << "-" << (i + 1) * bucketMs << " ms";
+        else range << ">= " << bucketCount * bucketMs << " ms";
+        std::cout << "  " << std::setw(12) << range.str() << "  " << std::setw(6) << buckets[i] << "  "
+                  << std::string(std::max(1, 40 * buckets[i] / (int)all.size()), '#') << std::endl;
+    }
+}
@@ -0,0 +1,226 @@
+#include "../Header/InputRecorder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+enum RecordTag : uint8_t {
+    TAG_FRAME = 0,
+    TAG_KEY = 1,
+    TAG_MOUSE_BUTTON = 2
+};
+
+static const char LOG_MAGIC[4] = { 'M', 'R', 'E', 'C' };
+static const uint32_t LOG_VERSION = 1;
+
+// Keys that ProcessInput polls every frame; their state is stored as a bitmask in each Frame record
+static const int polledKeys[] = {
+    GLFW_KEY_ESCAPE, GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D,
+    GLFW_KEY_UP, GLFW_KEY_DOWN, GLFW_KEY_LEFT, GLFW_KEY_RIGHT
+};
+static const int polledKeyCount = sizeof(polledKeys) / sizeof(polledKeys[0]);
+
+// --- Recording ---
+static std::ofstream recordFile;
+
+template <typename T>
+static void writeValue(const T& value)
+{
+    recordFile.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+bool startInputRecording(const char* path)
+{
+    recordFile.open(path, std::ios::binary | std::ios::trunc);
+    if (!recordFile.is_open()) {
+        std::cout << "ERROR::RECORDER:: unable to open " << path << std::endl;
+        return false;
+    }
+    recordFile.write(LOG_MAGIC, sizeof(LOG_MAGIC));
+    writeValue(LOG_VERSION);
+    std::cout << "Recording input to " << path << std::endl;
+    return true;
+}
+
+void stopInputRecording()
+{
+    if (recordFile.is_open()) recordFile.close();
+}
+
+bool isRecordingInput()
+{
+    return recordFile.is_open();
+}
+
+void recordFrame(GLFWwindow* window, float deltaTime)
+{
+    if (!recordFile.is_open()) return;
+
+    double x, y;
+    glfwGetCursorPos(window, &x, &y);
+    uint16_t keyMask = 0;
+    for (int i = 0; i < polledKeyCount; i++)
+        if (glfwGetKey(window, polledKeys[i]) == GLFW_PRESS) keyMask |= (1u << i);
+
+    writeValue(TAG_FRAME);
+    writeValue(deltaTime);
+    writeValue(x);
+    writeValue(y);
+    writeValue(keyMask);
+}
+
+void recordKeyEvent(int key, int scancode, int action, int mods)
+{
+    if (!recordFile.is_open()) return;
+
+    writeValue(TAG_KEY);
+    writeValue((int16_t)key);
+    writeValue((int16_t)scancode);
+    writeValue((uint8_t)action);
+    writeValue((uint8_t)mods);
+}
+
+void recordMouseButtonEvent(int button, int action, int mods, double x, double y)
+{
+    if (!recordFile.is_open()) return;
+
+    writeValue(TAG_MOUSE_BUTTON);
+    writeValue((uint8_t)button);
+    writeValue((uint8_t)action);
+    writeValue((uint8_t)mods);
+    writeValue(x);
+    writeValue(y);
+}
+
+// --- Replay ---
+static std::vector<char> replayData;
+static size_t replayOffset = 0;
+static bool replaying = false;
+static uint16_t replayKeyMask = 0;
+static double replayCursorX = 0.0, replayCursorY = 0.0;
+static std::vector<double> replayFrameTimes;
+
+template <typename T>
+static bool readValue(T& value)
+{
+    if (replayOffset + sizeof(T) > replayData.size()) return false;
+    std::memcpy(&value, replayData.data() + replayOffset, sizeof(T));
+    replayOffset += sizeof(T);
+    return true;
+}
+
+bool startInputReplay(const char* path)
+{
+    // The whole log is read up front so file I/O never shows up in replayed frame times
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cout << "ERROR::RECORDER:: unable to open " << path << std::endl;
+        return false;
+    }
+    replayData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    uint32_t version = 0;
+    if (replayData.size() < sizeof(LOG_MAGIC) + sizeof(version) || std::memcmp(replayData.data(), LOG_MAGIC, sizeof(LOG_MAGIC)) != 0) {
+        std::cout << "ERROR::RECORDER:: " << path << " is not an input log" << std::endl;
+        return false;
+    }
+    replayOffset = sizeof(LOG_MAGIC);
+    readValue(version);
+    if (version != LOG_VERSION) {
+        std::cout << "ERROR::RECORDER:: unsupported input log version " << version << std::endl;
+        return false;
+    }
+
+    replaying = true;
+    std::cout << "Replaying input from " << path << " (" << replayData.size() << " bytes)" << std::endl;
+    return true;
+}
+
+bool isReplayingInput()
+{
+    return replaying;
+}
+
+bool replayNextFrame(float& outDeltaTime)
+{
+    uint8_t tag;
+    if (!replaying || !readValue(tag) || tag != TAG_FRAME) return false;
+
+    return readValue(outDeltaTime) && readValue(replayCursorX) && readValue(replayCursorY) && readValue(replayKeyMask);
+}
+
+void replayPendingEvents(GLFWwindow* window, GLFWkeyfun keyCallback, GLFWmousebuttonfun mouseCallback)
+{
+    // Dispatch everything up to (not including) the next Frame record
+    while (replayOffset < replayData.size() && (uint8_t)replayData[replayOffset] != TAG_FRAME) {
+        uint8_t tag;
+        readValue(tag);
+
+        if (tag == TAG_KEY) {
+            int16_t key, scancode;
+            uint8_t action, mods;
+            if (!readValue(key) || !readValue(scancode) || !readValue(action) || !readValue(mods)) break;
+            keyCallback(window, key, scancode, action, mods);
+        }
+        else if (tag == TAG_MOUSE_BUTTON) {
+            uint8_t button, action, mods;
+            if (!readValue(button) || !readValue(action) || !readValue(mods) || !readValue(replayCursorX) || !readValue(replayCursorY)) break;
+            mouseCallback(window, button, action, mods);
+        }
+        else {
+            std::cout << "ERROR::RECORDER:: corrupt input log at offset " << replayOffset << std::endl;
+            replayOffset = replayData.size();
+        }
+    }
+}
+
+void recordReplayFrameTime(double ms)
+{
+    replayFrameTimes.push_back(ms);
+}
+
+void printReplayReport(const char* benchPath, const std::string& label)
+{
+    if (replayFrameTimes.empty()) return;
+
+    std::vector<double> sorted = replayFrameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0.0;
+    for (double ms : sorted) sum += ms;
+    double avg = sum / sorted.size();
+    double p50 = sorted[sorted.size() / 2];
+    double p99 = sorted[(size_t)(0.99 * (sorted.size() - 1))];
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "--- Replay [" << label << "]: " << sorted.size() << " frames, avg " << avg << " ms, p50 " << p50
+              << " ms, p99 " << p99 << " ms, max " << sorted.back() << " ms ---" << std::endl;
+
+    std::ofstream bench(benchPath, std::ios::app);
+    if (bench.is_open())
+        bench << std::fixed << std::setprecision(3) << label << "," << sorted.size() << "," << avg << "," << p50 << "," << p99 << "," << sorted.back() << "\n";
+    std::cout << std::defaultfloat;
+}
+
+int inputGetKey(GLFWwindow* window, int key)
+{
+    if (!replaying) return glfwGetKey(window, key);
+
+    for (int i = 0; i < polledKeyCount; i++)
+        if (polledKeys[i] == key) return (replayKeyMask & (1u << i)) ? GLFW_PRESS : GLFW_RELEASE;
+    return GLFW_RELEASE;
+}
+
+void inputGetCursorPos(GLFWwindow* window, double* xpos, double* ypos)
+{
+    if (!replaying) {
+        glfwGetCursorPos(window, xpos, ypos);
+        return;
+    }
+    *xpos = replayCursorX;
+    *ypos = replayCursorY;
+}
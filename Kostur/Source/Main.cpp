@@ -4,6 +4,10 @@
 #include <vector>
 #include <string>
 #include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <cerrno>
+#include <cstdlib>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -13,6 +17,21 @@
 #include "../Header/model.hpp"
 #include "../Header/TextUtil.h"
 #include "../Header/Util.h"
+#include "../Header/ResourceRegistry.h"
+#include "../Header/StartupTrace.h"
+#include "../Header/InputLatency.h"
+#include "../Header/InputRecorder.h"
+#include "../Header/RenderQueue.h"
+#include "../Header/GeometryPool.h"
+#include "../Header/Simulation.h"
+#include "../Header/AssetManager.h"
+#include "../Header/AssetPack.h"
+#include "../Header/BackgroundLoader.h"
+#include "../Header/FileWatcher.h"
+#include "../Header/MemoryProbe.h"
+#include "../Header/HudRenderer.h"
+#include "../Header/PolylineRenderer.h"
+#include "../Header/PolylineLod.h"
 
 // --- CONSTANTS & SETTINGS ---
 const unsigned int SCR_WIDTH = 1920;
@@ -21,27 +40,22 @@ const float MAP_SIZE = 10.0f;
 
 // --- GLOBAL STATE ---
 
-// Camera & Modes
-glm::vec3 cameraPos = glm::vec3(0.0f, 2.0f, 2.0f);
+// Camera
 glm::vec3 cameraFront =glm::normalize(glm::vec3(0.0f, -1.0f, -1.0f));
 glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
 
-// Saved positions for mode switching
-glm::vec3 savedWalkPos = glm::vec3(0.0f, 2.0f, 5.0f);
-glm::vec3 savedMeasurePos = glm::vec3(0.0f, 10.0f, 10.0f);
-
-bool isWalkingMode = true;
-
 // Player
-glm::vec3 playerPos = glm::vec3(0.0f, 0.0f, 0.0f);
-glm::vec3 lastPlayerPos = glm::vec3(0.0f, 0.0f, 0.0f);
 float playerSpeed = 5.0f;
-float playerRotation = 180.0f;
-float totalWalkDistance = 0.0f;
 
-// Measurement (Pins)
-std::vector<glm::vec3> measurementPoints;
-float totalMeasuredLength = 0.0f;
+// Simulation (modes, camera, player, pins) runs on its own thread at a fixed tick rate;
+// a frame renders one snapshot of it, positions blended between the last two ticks
+Simulation simulation;
+std::shared_ptr<const SimState> frameState;
+float frameAlpha = 0.0f;
+const float simulationTickRate = 120.0f;
+uint16_t sentHeldKeys = 0;
+uint64_t sentInputSequence = 0;
+std::shared_ptr<const ModelBvh> pickedPlayerShape, pickedPinShape;   // what the simulation picks against
 
 // Timing
 float deltaTime = 0.0f;
@@ -52,24 +66,82 @@ float iconSize = 200.0f;
 float iconPadding = 20.0f;
 
 // Rendering Resources (VAO/VBO/Textures)
-unsigned int mapVAO, mapVBO, mapTexture;
-unsigned int uiVAO, uiVBO, iconWalkTex, iconMeasureTex;
-unsigned int lineVAO, lineVBO;
+unsigned int mapVAO, mapVBO;
+AssetHandle mapTexture, iconWalkTex, iconMeasureTex;
+
+// Materials for geometry that doesn't come from a model file (created in InitScene)
+Material mapMaterial, pinMaterial;
+
+// Measurement route, thick and anti-aliased at any zoom; uploaded only when the points change.
+// Only the vertices whose simplification error would show (lodPixelError) are drawn
+PolylineRenderer routeLines;
+PolylineLod routeLod;
+uint64_t routeLodRevision = UINT64_MAX;    // SimState::measurementRevision routeLod was built from
+float routeWidth = 5.0f;   // pixels
+
+// Sorted draw submission for the scene (F4 shows bind statistics)
+RenderQueue renderQueue;
+bool showRenderStats = false;
+
+// Mode icon and distance readout, rebuilt only when what they show changes (created in InitHud)
+HudRenderer hud;
+int hudIcon, hudDistance;
+
+// Model LODs are picked so their simplification error stays under this many pixels
+float lodPixelError = 1.0f;
 
 bool depthTestEnabled = true;
 bool faceCullingEnabled = false;
 
-const double targetFPS = 75.0;
-const double frameTimeLimit = 1.0 / targetFPS;
+// --fps=N changes the render cap, --fps=0 renders uncapped; the simulation rate is unaffected
+double targetFPS = 75.0;
+double frameTimeLimit = 1.0 / targetFPS;
+
+// Models import on loader threads; their GPU uploads get at most this much of each frame (--load-budget-ms=N)
+double loadBudgetMs = 2.0;
+
+// Resources/ and Shaders/ are read from this pack when it exists (--pack=file);
+// --build-pack[=file] writes it from the loose files and exits
+std::string assetPackPath = "assets.pak";
+bool buildPackOnly = false;
+
+// Meshes free their vertices and indices once uploaded unless --keep-mesh-data is given.
+// --load-bench=model[,packed] loads one model synchronously, appends its allocation count
+// and peak RSS to load_bench.csv (labelled keep/release) and exits
+bool keepMeshData = false;
+std::string loadBenchModel;
+bool loadBenchPacked = false;
+const char* loadBenchPath = "load_bench.csv";
+
+// Memory accounting (F1 shows the HUD page, F2 dumps the registry to JSON)
+size_t memoryBudgetMB = 512;
+bool showMemoryHud = false;
+const char* resourceDumpPath = "resources.json";
+
+// Startup benchmark (--startup-bench[=cold|warm]): hidden window, exit once both models are uploaded
+bool headlessMode = false;
+bool startupBenchmark = false;
+std::string startupBenchLabel = "warm";
+const char* startupBenchPath = "startup_bench.csv";
+
+// Input recording (--record=file) and replay (--replay=file)
+std::string recordPath;
+std::string replayPath;
+const char* replayBenchPath = "replay_bench.csv";
 
 // --- FUNCTION PROTOTYPES ---
 GLFWwindow* InitGLFW();
+AssetHandle AcquireModel(const std::string& path, bool packTextures);
+int RunLoadBenchmark();
 void InitScene();
 void ProcessInput(GLFWwindow* window);
-void RenderScene(Shader& shader, Model& humanoid, Model& pin);
-void RenderUI(Shader& shader, Shader& textShader);
-void ToggleMode();
-bool GetGroundIntersection(GLFWwindow* window, double mouseX, double mouseY, glm::vec3& outIntersection);
+void InitSimulation();
+void InitHud();
+void RenderScene(const SimState& state, ShaderVariants& shaders, Model& humanoid, Model& pin);
+void RenderUI(const SimState& state, ShaderVariants& shaders, Shader& textShader);
+void PushSimEvent(SimEventType type, uint64_t sequence, double x = 0.0, double y = 0.0);
+bool ParseSizeArg(const std::string& arg, const std::string& prefix, size_t& value);
+bool ParseDoubleArg(const std::string& arg, const std::string& prefix, double& value);
 
 // Callbacks
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -79,81 +151,338 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 // ----------------------------------------------------------------------------
 // MAIN FUNCTION
 // ----------------------------------------------------------------------------
-int main()
+int main(int argc, char** argv)
 {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--memory-budget-mb=", 0) == 0) {
+            if (!ParseSizeArg(arg, "--memory-budget-mb=", memoryBudgetMB)) return -1;
+        }
+        else if (arg == "--headless")
+            headlessMode = true;
+        else if (arg.rfind("--startup-bench", 0) == 0) {
+            startupBenchmark = true;
+            headlessMode = true;
+            size_t eq = arg.find('=');
+            if (eq != std::string::npos) startupBenchLabel = arg.substr(eq + 1);
+        }
+        else if (arg.rfind("--record=", 0) == 0)
+            recordPath = arg.substr(std::string("--record=").size());
+        else if (arg.rfind("--replay=", 0) == 0)
+            replayPath = arg.substr(std::string("--replay=").size());
+        else if (arg.rfind("--fps=", 0) == 0) {
+            if (!ParseDoubleArg(arg, "--fps=", targetFPS)) return -1;
+            frameTimeLimit = targetFPS > 0.0 ? 1.0 / targetFPS : 0.0;
+        }
+        else if (arg.rfind("--pack=", 0) == 0)
+            assetPackPath = arg.substr(std::string("--pack=").size());
+        else if (arg.rfind("--build-pack", 0) == 0) {
+            buildPackOnly = true;
+            size_t eq = arg.find('=');
+            if (eq != std::string::npos) assetPackPath = arg.substr(eq + 1);
+        }
+        else if (arg.rfind("--load-budget-ms=", 0) == 0) {
+            if (!ParseDoubleArg(arg, "--load-budget-ms=", loadBudgetMs)) return -1;
+        }
+        else if (arg == "--keep-mesh-data")
+            keepMeshData = true;
+        else if (arg.rfind("--load-bench=", 0) == 0) {
+            loadBenchModel = arg.substr(std::string("--load-bench=").size());
+            size_t comma = loadBenchModel.find(',');
+            if (comma != std::string::npos) {
+                loadBenchPacked = loadBenchModel.substr(comma + 1) == "packed";
+                loadBenchModel = loadBenchModel.substr(0, comma);
+            }
+            headlessMode = true;
+        }
+    }
+    setMemoryBudget(memoryBudgetMB * 1024 * 1024);
+
+    if (buildPackOnly) {
+        std::vector<std::string> roots;
+        roots.push_back("Resources");
+        roots.push_back("Shaders");
+        return buildAssetPack(assetPackPath, roots) ? 0 : -1;
+    }
+    openAssetPack(assetPackPath);
+
+    if (!replayPath.empty() && !startInputReplay(replayPath.c_str())) return -1;
+    if (!recordPath.empty() && replayPath.empty()) startInputRecording(recordPath.c_str());
+
     // 1. Initialize Window & OpenGL
     GLFWwindow* window = InitGLFW();
     if (!window) return -1;
+    if (!loadBenchModel.empty())
+        return RunLoadBenchmark();
 
     // 2. Load Shaders & Models
-    Shader phongShader("Shaders/phong.vert", "Shaders/phong.frag");
-    Shader uiShader("Shaders/text.vert", "Shaders/text.frag");
+    beginStartupPhase("shaders");
+    AssetHandle uiAsset = acquireShader("Shaders/text.vert", "Shaders/text.frag");
+    Shader& uiShader = *uiAsset.get<Shader>();
+    // phong is compiled per material/lighting combination, the first time a draw needs it
+    ShaderVariants phongShaders("Shaders/phong.vert", "Shaders/phong.frag", MATERIAL_SHADER_FEATURES);
+    phongShaders.programSetup = Material::SetupProgram;
+
+    // Edits under Shaders/ recompile in the background and swap in between frames
+    if (!headlessMode) {
+        bool parallel = Shader::enableParallelCompile();
+        if (startFileWatcher("Shaders"))
+            std::cout << "Watching Shaders/ for changes (" << (parallel ? "parallel" : "blocking") << " compile)" << std::endl;
+    }
+
+    // every variant the scene can ask for, so none compiles (and stalls a frame) when the first pin
+    // or a light bucket appears: the map and the packed player while walking, the map and pins under
+    // each pin light count while measuring, and the unlit placeholder box of a loading model
+    std::vector<unsigned int> sceneVariants = { 0, MATERIAL_SHADER_LIT | MATERIAL_SHADER_DIFFUSE_MAP, MATERIAL_SHADER_LIT | MATERIAL_SHADER_DIFFUSE_ARRAY };
+    for (unsigned int lights : { MATERIAL_SHADER_LIGHTS_4, MATERIAL_SHADER_LIGHTS_16, MATERIAL_SHADER_LIGHTS_32 }) {
+        sceneVariants.push_back(MATERIAL_SHADER_LIT | lights | MATERIAL_SHADER_DIFFUSE_MAP);
+        sceneVariants.push_back(MATERIAL_SHADER_LIT | lights);
+    }
+    phongShaders.prewarm(sceneVariants);
 
-    Model humanoidModel("Resources/bob-model/bob_the_builder.obj");
-    Model pinModel("Resources/pin-model/map_pin.obj");
+    // models only queue their import here and render as bounding boxes until uploaded
+    beginStartupPhase("models");
+    startBackgroundLoader();
+    AssetHandle humanoidAsset = AcquireModel("Resources/bob-model/bob_the_builder.obj", true); // packed: one draw, one texture array
+    AssetHandle pinAsset = AcquireModel("Resources/pin-model/map_pin.obj", false);
+    Model& humanoidModel = *humanoidAsset.get<Model>();
+    Model& pinModel = *pinAsset.get<Model>();
 
     // 3. Initialize Geometry (Map, UI Quad, Lines)
+    beginStartupPhase("scene");
     InitScene();
+    InitSimulation();
 
     // 4. Initialize Text System
+    beginStartupPhase("text");
     initText(uiShader.ID, "Resources/Antonio-Regular.ttf");
+    InitHud();
 
     glEnable(GL_DEPTH_TEST);
     glCullFace(GL_BACK);
     glFrontFace(GL_CCW);
 
+    beginStartupPhase("first_frame");
+    bool firstFramePresented = false;
+
     // --- MAIN LOOP ---
     while (!glfwWindowShouldClose(window))
     {
         // Timing
         float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
 
-        if (deltaTime < frameTimeLimit) {
-            continue;
+        if (isReplayingInput()) {
+            // Replay runs unthrottled with the recorded deltas as timestep
+            if (!replayNextFrame(deltaTime)) break;
         }
+        else {
+            deltaTime = currentFrame - lastFrame;
+
+            if (deltaTime < frameTimeLimit) {
+                continue;
+            }
 
-        lastFrame = currentFrame;
+            lastFrame = currentFrame;
+            recordFrame(window, deltaTime);
+        }
 
-        // Input
+        // Input: replay steps the simulation here with the recorded delta, otherwise its thread already runs
         ProcessInput(window);
+        if (!simulation.isThreaded())
+            simulation.step(deltaTime);
+        frameState = simulation.snapshot();
+        frameAlpha = simulation.interpolation(*frameState);
+        beginInputFrame(frameState->appliedSequence);
+
+        // Upload whatever the loader threads have finished, within the frame's budget
+        processMainThreadWork(loadBudgetMs);
+
+        // Clicks are picked against the models' BVHs as soon as they finish loading
+        if (humanoidModel.pickBvh != pickedPlayerShape || pinModel.pickBvh != pickedPinShape) {
+            pickedPlayerShape = humanoidModel.pickBvh;
+            pickedPinShape = pinModel.pickBvh;
+            simulation.setPickShapes(pickedPlayerShape, pickedPinShape);
+        }
+
+        // Shader hot reload: start compiling edited files, swap in whatever finished linking
+        std::vector<std::string> changedFiles = takeChangedFiles();
+        if (!changedFiles.empty()) reloadShaders(changedFiles);
+        pollShaderReloads();
 
         // Clear Screen
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // --- RENDER 3D SCENE ---
-        RenderScene(phongShader, humanoidModel, pinModel);
+        RenderScene(*frameState, phongShaders, humanoidModel, pinModel);
 
         // --- RENDER 2D UI ---
-        RenderUI(phongShader, uiShader);
+        RenderUI(*frameState, phongShaders, uiShader);
 
         // Swap Buffers
         glfwSwapBuffers(window);
+        onFramePresented(glfwGetTime());
+
+        // the first frame only shows placeholder boxes; tracing goes on until both models are drawn for real
+        if (isStartupTracing()) {
+            if (!firstFramePresented) {
+                glFinish(); // make sure the first frame actually reached the screen before marking it
+                markStartupMilestone("first_frame");
+                beginStartupPhase("model_uploads");
+                firstFramePresented = true;
+            }
+            if (!humanoidModel.IsLoading() && !pinModel.IsLoading()) {
+                if (humanoidModel.IsReady() && pinModel.IsReady())
+                    markStartupMilestone("models_ready");
+                printStartupReport();
+                if (startupBenchmark) {
+                    appendStartupBenchmark(startupBenchPath, startupBenchLabel);
+                    glfwSetWindowShouldClose(window, true);
+                }
+            }
+        }
+
         glfwPollEvents();
+
+        if (isReplayingInput()) {
+            recordReplayFrameTime((glfwGetTime() - currentFrame) * 1000.0);
+            replayPendingEvents(window, key_callback, mouse_callback);
+        }
     }
 
-    // Cleanup
+    simulation.stop();
+    stopBackgroundLoader();
+    stopFileWatcher();
+    closeAssetPack();
+
+    if (isReplayingInput())
+        printReplayReport(replayBenchPath, replayPath + " @ build " + __DATE__ + " " + __TIME__);
+    stopInputRecording();
+
+    printInputLatencyReport((targetFPS > 0.0 ? "spin-wait limiter @ " + std::to_string((int)targetFPS) + " FPS, " : std::string("uncapped, "))
+                            + std::to_string((int)simulationTickRate) + " Hz simulation" + (isReplayingInput() ? " (stepped)" : " thread"));
+
+    // Cleanup: drop every handle, then unload everything the asset manager still caches
+    humanoidAsset.reset();
+    pinAsset.reset();
+    phongShaders.clear();
+    uiAsset.reset();
+    hud.release();
+    routeLines.release();
+    releaseText();
+    mapTexture.reset();
+    iconWalkTex.reset();
+    iconMeasureTex.reset();
+    purgeUnreferencedAssets();
+    mapMaterial.Release();
+    pinMaterial.Release();
+    Model::ReleaseShared();
     glDeleteVertexArrays(1, &mapVAO);
     glDeleteBuffers(1, &mapVBO);
-    glDeleteTextures(1, &mapTexture);
+    untrackResource(ResourceKind::VertexArray, mapVAO);
+    untrackResource(ResourceKind::Buffer, mapVBO);
 
     glfwTerminate();
     return 0;
 }
 
+// ----------------------------------------------------------------------------
+// COMMAND LINE
+// ----------------------------------------------------------------------------
+// the number after prefix; false (and a usage message) unless all of the rest is one
+bool ParseSizeArg(const std::string& arg, const std::string& prefix, size_t& value) {
+    const char* text = arg.c_str() + prefix.size();
+    char* end;
+    errno = 0;
+    unsigned long long parsed = std::strtoull(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || arg[prefix.size()] == '-') {
+        std::cout << "Invalid value in " << arg << ": expected " << prefix << "<non-negative integer>" << std::endl;
+        return false;
+    }
+    value = (size_t)parsed;
+    return true;
+}
+
+bool ParseDoubleArg(const std::string& arg, const std::string& prefix, double& value) {
+    const char* text = arg.c_str() + prefix.size();
+    char* end;
+    errno = 0;
+    double parsed = std::strtod(text, &end);
+    if (end == text || *end != '\0' || errno == ERANGE || !std::isfinite(parsed) || parsed < 0.0) {
+        std::cout << "Invalid value in " << arg << ": expected " << prefix << "<non-negative number>" << std::endl;
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
 // ----------------------------------------------------------------------------
 // INITIALIZATION FUNCTIONS
 // ----------------------------------------------------------------------------
+// Models are cached by the asset manager like textures: the same file (by path or content)
+// with the same packing is imported once, and its geometry goes back to the pools when evicted
+AssetHandle AcquireModel(const std::string& path, bool packTextures) {
+    std::string canonical = canonicalAssetPath(path);
+    std::vector<std::string> files(1, canonical);
+    uint64_t hash = hashFiles(files);
+    if (hash) hash = hashBytes(&packTextures, sizeof(packTextures), hash);
+
+    return acquireAsset(AssetKind::Model, canonical + (packTextures ? "#packed" : ""), hash, [&]() {
+        // bytes stay 0: the meshes don't exist yet, and the registry tracks them once uploaded
+        std::shared_ptr<Model> model = Model::LoadAsync(canonical, packTextures, 1024, keepMeshData);
+        AssetData data;
+        data.object = model;
+        data.unload = [model]() { model->Unload(); };
+        return data;
+    });
+}
+
+// Peak RSS includes the GL context created before the load; compare keep and release runs
+// of the same model (or runs of two builds) rather than reading the absolute numbers
+int RunLoadBenchmark() {
+    if (!countingAllocations())
+        std::cout << "Load benchmark: allocation counts need a build with MEMORY_PROBE_COUNT_ALLOCATIONS, recording 0" << std::endl;
+    size_t allocationsBefore = allocationCount(), bytesBefore = allocatedBytes();
+    double start = glfwGetTime();
+    bool ok;
+    {
+        Model model(loadBenchModel, false, loadBenchPacked, 1024, keepMeshData);
+        double ms = (glfwGetTime() - start) * 1000.0;
+        ok = model.IsReady();
+        if (ok)
+            appendLoadBenchmark(loadBenchPath, keepMeshData ? "keep" : "release", loadBenchModel + (loadBenchPacked ? " (packed)" : ""), ms,
+                                allocationCount() - allocationsBefore, allocatedBytes() - bytesBefore, peakResidentBytes(),
+                                trackedBytes(ResourceKind::CpuData));
+        else
+            std::cout << "ERROR::LOAD_BENCH:: failed to load " << loadBenchModel << std::endl;
+        model.Unload();
+    }
+    purgeUnreferencedAssets();
+    glfwTerminate();
+    return ok ? 0 : -1;
+}
+
 GLFWwindow* InitGLFW() {
+    beginStartupPhase("glfw_init");
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    GLFWmonitor* primaryMonitor = glfwGetPrimaryMonitor();
-    const GLFWvidmode* mode = glfwGetVideoMode(primaryMonitor);
-    GLFWwindow* window = glfwCreateWindow(mode->width, mode->height, "3D Map Project", primaryMonitor, NULL);
+    GLFWwindow* window = NULL;
+    if (headlessMode) {
+        // Hidden window: we still need a context, but nothing is shown (and there may be no monitor)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "3D Map Project", NULL, NULL);
+    }
+    else {
+        GLFWmonitor* primaryMonitor = glfwGetPrimaryMonitor();
+        const GLFWvidmode* mode = primaryMonitor ? glfwGetVideoMode(primaryMonitor) : NULL;
+        if (mode)
+            window = glfwCreateWindow(mode->width, mode->height, "3D Map Project", primaryMonitor, NULL);
+        else
+            std::cout << "No monitor found; run with --headless" << std::endl;
+    }
 
     if (window == NULL) {
         std::cout << "Failed to create GLFW window" << std::endl;
@@ -162,15 +491,22 @@ GLFWwindow* InitGLFW() {
     }
 
     glfwMakeContextCurrent(window);
-    glViewport(0, 0, mode->width, mode->height);
+    int framebufferWidth, framebufferHeight;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    glViewport(0, 0, framebufferWidth, framebufferHeight);
 
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetMouseButtonCallback(window, mouse_callback);
-    glfwSetKeyCallback(window, key_callback);
+    // While replaying, input comes only from the log
+    if (replayPath.empty()) {
+        glfwSetMouseButtonCallback(window, mouse_callback);
+        glfwSetKeyCallback(window, key_callback);
+    }
 
+    beginStartupPhase("cursor");
     GLFWcursor* cursor = loadImageToCursor("Resources/compass.png");
     glfwSetCursor(window, cursor);
 
+    beginStartupPhase("glew");
     if (glewInit() != GLEW_OK) {
         std::cout << "Failed to initialize GLEW" << std::endl;
         return NULL;
@@ -197,334 +533,278 @@ void InitScene() {
     glBindBuffer(GL_ARRAY_BUFFER, mapVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(mapVertices), mapVertices, GL_STATIC_DRAW);
 
-    // Layouts: 0=Pos, 1=Norm, 2=Tex
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    mapTexture = TextureFromFile("map.jpg", "Resources");
-
-    // B) UI Quad Setup
-    float uiVertices[] = {
-        // Pos(x,y,z)               // Normal               // Tex
-        0.0f, 0.0f, 0.0f,          0.0f, 0.0f, 1.0f,       0.0f, 1.0f,
-        1.0f, 0.0f, 0.0f,          0.0f, 0.0f, 1.0f,       1.0f, 1.0f, 
-        0.0f, 1.0f, 0.0f,          0.0f, 0.0f, 1.0f,       0.0f, 0.0f, 
-
-        1.0f, 0.0f, 0.0f,          0.0f, 0.0f, 1.0f,       1.0f, 1.0f,
-        1.0f, 1.0f, 0.0f,          0.0f, 0.0f, 1.0f,       1.0f, 0.0f,
-        0.0f, 1.0f, 0.0f,          0.0f, 0.0f, 1.0f,       0.0f, 0.0f
-    };
+    // Layouts: 0=Pos, 1=Norm, 2=Tex, same as the mesh Vertex
+    static_assert(sizeof(Vertex) == 8 * sizeof(float), "map and UI arrays are laid out as Vertex");
+    VertexLayoutOf<Vertex>::type::apply();
+    trackResource(ResourceKind::VertexArray, mapVAO, 0, "Scene");
+    trackResource(ResourceKind::Buffer, mapVBO, sizeof(mapVertices), "Scene");
+
+    // the map shows its pack preview on the first frame and sharpens once the full decode is uploaded
+    mapTexture = acquireTextureProgressive("Resources/map.jpg");
+    mapMaterial = Material(glm::vec3(1.0f), glm::vec3(1.0f), glm::vec3(0.2f), 32.0f, mapTexture.id());
 
-    glGenVertexArrays(1, &uiVAO);
-    glGenBuffers(1, &uiVBO);
-    glBindVertexArray(uiVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, uiVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(uiVertices), uiVertices, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    iconWalkTex = TextureFromFile("walking.png", "Resources");
-    iconMeasureTex = TextureFromFile("ruler.png", "Resources");
-
-    // C) Line Setup
-    glGenVertexArrays(1, &lineVAO);
-    glGenBuffers(1, &lineVBO);
-    glBindVertexArray(lineVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    // B) UI icons (drawn by the HUD, see InitHud); drawn at iconSize pixels, so downsampled after decoding
+    iconWalkTex = acquireTexture("Resources/walking.png", TextureVariant::Mipmapped, "UI", (int)iconSize);
+    iconMeasureTex = acquireTexture("Resources/ruler.png", TextureVariant::Mipmapped, "UI", (int)iconSize);
+
+    // Measurement pins, drawn in flat red
+    pinMaterial = Material(glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.2f), 32.0f);
+
+    // C) Route between the pins
+    routeLines.init();
+}
+
+void InitSimulation() {
+    SimConfig config;
+    config.tickRate = simulationTickRate;
+    config.mapSize = MAP_SIZE;
+    config.playerSpeed = playerSpeed;
+    config.cameraSpeed = 5.0f;
+    config.cameraFront = cameraFront;
+    config.screenWidth = SCR_WIDTH;
+    config.screenHeight = SCR_HEIGHT;
+    config.fovy = glm::radians(45.0f);
+    config.iconSize = iconSize;
+    config.iconPadding = iconPadding;
+    simulation.init(config, SimState());
+
+    // A replay has to see exactly the recorded timesteps, so it steps the simulation from the main loop
+    if (!isReplayingInput())
+        simulation.start();
+}
+
+// needs the glyph atlas (initText) and the icon textures (InitScene)
+void InitHud() {
+    hud.init((float)SCR_WIDTH, (float)SCR_HEIGHT);
+    float iconX = SCR_WIDTH - (iconSize + iconPadding);
+    float iconY = SCR_HEIGHT - (iconSize + iconPadding);
+    hudIcon = hud.addSprite(iconWalkTex.id(), iconX, iconY, iconSize, iconSize);
+    hudDistance = hud.addText("", 25.0f, SCR_HEIGHT - 50.0f, 1.0f, glm::vec4(1.0f, 1.0f, 0.0f, 1.0f));
+    hud.addText("Mijat Krivokapic SV41/2022", 25.0f, 25.0f, 1.0f, glm::vec4(1.0f, 1.0f, 0.0f, 1.0f));
 }
 
 // ----------------------------------------------------------------------------
 // RENDER LOGIC
 // ----------------------------------------------------------------------------
-void RenderScene(Shader& shader, Model& humanoid, Model& pin) {
-    shader.use();
-
-    // 1. Setup Lights
-    shader.setVec3("uSun.direction", -0.2f, -1.0f, -0.3f);
-    shader.setVec3("uSun.kA", 0.4f, 0.4f, 0.4f);
-    shader.setVec3("uSun.kD", 0.4f, 0.4f, 0.4f);
-    shader.setVec3("uSun.kS", 0.25f, 0.25f, 0.25f);
-    shader.setVec3("uViewPos", cameraPos);
-
-    // Point lights (Pins)
-    int nrLights = (!isWalkingMode) ? std::min((int)measurementPoints.size(), 32) : 0;
-    shader.setInt("uNrActiveLights", nrLights);
-
-    for (int i = 0; i < nrLights; i++) {
-        std::string num = std::to_string(i);
-        shader.setVec3("pointLights[" + num + "].position", measurementPoints[i] + glm::vec3(0.0f, 1.5f, 0.0f));
-        shader.setVec3("pointLights[" + num + "].kA", 0.0f, 0.0f, 0.0f);
-        shader.setVec3("pointLights[" + num + "].kD", 0.5f, 0.0f, 0.0f); // Red light
-        shader.setVec3("pointLights[" + num + "].kS", 0.5f, 0.0f, 0.0f);
-        shader.setFloat("pointLights[" + num + "].constant", 1.0f);
-        shader.setFloat("pointLights[" + num + "].linear", 0.35f);
-        shader.setFloat("pointLights[" + num + "].quadratic", 0.44f);
-    }
+void RenderScene(const SimState& state, ShaderVariants& shaders, Model& humanoid, Model& pin) {
+    const std::vector<glm::vec3>& measurementPoints = state.measurementPoints;
+    glm::vec3 viewPos = state.displayCameraPos(frameAlpha);
+    int nrLights = (!state.isWalkingMode) ? std::min((int)measurementPoints.size(), 32) : 0;
+    std::vector<glm::vec3> lightPositions(measurementPoints.begin(), measurementPoints.begin() + nrLights);
+
+    renderQueue.begin(viewPos, 100.0f);
+    // every scene draw is lit; the light array only as large as the pins need
+    renderQueue.setPassFeatures(RenderPass::Opaque, MATERIAL_SHADER_LIT | MaterialLightFeatures(nrLights));
 
-    // 2. Setup Matrices
     glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-    glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, glm::vec3(0.0f, 1.0f, 0.0f));
-    shader.setMat4("uP", projection);
-    shader.setMat4("uV", view);
-
-    // 3. Draw Map
-    glm::mat4 model = glm::mat4(1.0f);
-    shader.setMat4("uM", model);
-    shader.setVec3("uMaterial.kA", 1.0f, 1.0f, 1.0f);
-    shader.setVec3("uMaterial.kD", 1.0f, 1.0f, 1.0f);
-    shader.setVec3("uMaterial.kS", 0.2f, 0.2f, 0.2f);
-    shader.setFloat("uMaterial.shine", 32.0f);
-
-    shader.setInt("uUseTexture", 1);
-    shader.setInt("uTexture", 0);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, mapTexture);
-    glBindVertexArray(mapVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-
-    // 4. Draw Player (Walking Mode)
-    if (isWalkingMode) {
-        float dist = glm::distance(playerPos, lastPlayerPos);
-        totalWalkDistance += dist;
-        lastPlayerPos = playerPos;
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, playerPos);
-        model = glm::rotate(model, glm::radians(playerRotation), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(0.01f));
-        shader.setMat4("uM", model);
-        humanoid.Draw(shader);
-    }
-    // 5. Draw Measurement Tools (Measuring Mode)
-    else {
-        shader.setInt("uUseTexture", 0); 
-
-        // Draw Pins
-        shader.setVec3("uMaterial.kA", 1.0f, 0.0f, 0.0f);
-        shader.setVec3("uMaterial.kD", 1.0f, 0.0f, 0.0f);
-
-        for (auto& point : measurementPoints) {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, point);
-            model = glm::translate(model, glm::vec3(0.0f, 0.75f, 0.0f));
-            model = glm::scale(model, glm::vec3(0.2f));
-            shader.setMat4("uM", model);
-            pin.Draw(shader);
+    glm::mat4 view = glm::lookAt(viewPos, viewPos + cameraFront, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 viewProjection = projection * view;
+
+    // 1. Per-pass setup: lights and matrices are set once per program bind, not per draw
+    renderQueue.setPassSetup(RenderPass::Opaque, [=](Shader& s) {
+        s.setVec3("uSun.direction", -0.2f, -1.0f, -0.3f);
+        s.setVec3("uSun.kA", 0.4f, 0.4f, 0.4f);
+        s.setVec3("uSun.kD", 0.4f, 0.4f, 0.4f);
+        s.setVec3("uSun.kS", 0.25f, 0.25f, 0.25f);
+        s.setVec3("uViewPos", viewPos);
+
+        // Point lights (Pins)
+        s.setInt("uNrActiveLights", nrLights);
+        for (int i = 0; i < nrLights; i++) {
+            std::string num = std::to_string(i);
+            s.setVec3("pointLights[" + num + "].position", lightPositions[i] + glm::vec3(0.0f, 1.5f, 0.0f));
+            s.setVec3("pointLights[" + num + "].kA", 0.0f, 0.0f, 0.0f);
+            s.setVec3("pointLights[" + num + "].kD", 0.5f, 0.0f, 0.0f); // Red light
+            s.setVec3("pointLights[" + num + "].kS", 0.5f, 0.0f, 0.0f);
+            s.setFloat("pointLights[" + num + "].constant", 1.0f);
+            s.setFloat("pointLights[" + num + "].linear", 0.35f);
+            s.setFloat("pointLights[" + num + "].quadratic", 0.44f);
         }
 
-        // Draw Lines
-        if (measurementPoints.size() > 1) {
-            shader.setVec3("uMaterial.kA", 1.0f, 0.0f, 0.0f);
-            shader.setVec3("uMaterial.kD", 0.0f, 0.0f, 0.0f);
-
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3(0.0f, 0.05f, 0.0f)); // Slightly above ground
-            shader.setMat4("uM", model);
-
-            glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
-            glBufferData(GL_ARRAY_BUFFER, measurementPoints.size() * sizeof(glm::vec3), &measurementPoints[0], GL_DYNAMIC_DRAW);
-            glBindVertexArray(lineVAO);
-            glLineWidth(5.0f);
-            glDrawArrays(GL_LINE_STRIP, 0, measurementPoints.size());
-            glLineWidth(1.0f);
-        }
-    }
-}
+        s.setMat4(s.viewProjectionLocation, viewProjection);
+    });
 
-void RenderUI(Shader& shader, Shader& textShader) {
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    LodContext lod;
+    lod.viewPos = viewPos;
+    lod.pixelScale = SCR_HEIGHT / (2.0f * std::tan(glm::radians(45.0f) * 0.5f));
+    lod.maxPixelError = lodPixelError;
 
-    // A) Icon
-    shader.use();
-    glm::mat4 uiProj = glm::ortho(0.0f, (float)SCR_WIDTH, 0.0f, (float)SCR_HEIGHT);
-    shader.setMat4("uP", uiProj);
-    shader.setMat4("uV", glm::mat4(1.0f));
+    // 2. Map
+    renderQueue.submitArrays(RenderPass::Opaque, shaders, mapVAO, GL_TRIANGLES, 0, 6, glm::mat4(1.0f), mapMaterial);
 
-    glm::mat4 model = glm::mat4(1.0f);
-    float iconX = SCR_WIDTH - (iconSize + iconPadding);
-    float iconY = SCR_HEIGHT - (iconSize + iconPadding);
-    model = glm::translate(model, glm::vec3(iconX, iconY, 0.0f));
-    model = glm::scale(model, glm::vec3(iconSize, iconSize, 1.0f));
-    shader.setMat4("uM", model);
+    // 3. Player (Walking Mode)
+    if (state.isWalkingMode) {
+        glm::mat4 model = playerModelMatrix(state.displayPlayerPos(frameAlpha), state.playerRotation);
+        humanoid.Submit(renderQueue, RenderPass::Opaque, shaders, model, nullptr, &lod);
+    }
+    // 4. Measurement Tools (Measuring Mode)
+    else {
+        // Pins
 
-    // Unlit material for UI
-    shader.setVec3("uSun.kA", 1.0f, 1.0f, 1.0f);
-    shader.setVec3("uSun.kD", 0.0f, 0.0f, 0.0f);
-    shader.setInt("uNrActiveLights", 0);
-    shader.setVec3("uMaterial.kA", 1.0f, 1.0f, 1.0f);
-    shader.setVec3("uMaterial.kD", 0.0f, 0.0f, 0.0f);
+        for (auto& point : measurementPoints)
+            pin.Submit(renderQueue, RenderPass::Opaque, shaders, pinModelMatrix(point), &pinMaterial, &lod);
 
-    shader.setInt("uUseTexture", 1);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, isWalkingMode ? iconWalkTex : iconMeasureTex);
+    }
 
-    glBindVertexArray(uiVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    // Everything submitted above is executed here, sorted
+    renderQueue.flush();
 
-    // B) Text
+    // 5. Route, blended over the opaque scene: one instanced draw, the buffer rewritten only when the selection changes
+    if (state.measurementRevision != routeLodRevision) {
+        routeLod.build(measurementPoints);
+        routeLodRevision = state.measurementRevision;
+    }
+    if (!state.isWalkingMode) {
+        routeLod.select(lod.viewPos, lod.pixelScale, lod.maxPixelError);
+        routeLines.setPoints(routeLod.selectedPoints(), routeLod.revision());
+        glm::mat4 lifted = glm::translate(viewProjection, glm::vec3(0.0f, 0.05f, 0.0f)); // Slightly above ground
+        // the real framebuffer's, not SCR_WIDTH x SCR_HEIGHT: the shader compares against gl_FragCoord
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        routeLines.draw(lifted, glm::vec4((float)viewport[0], (float)viewport[1], (float)viewport[2], (float)viewport[3]), routeWidth, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+    }
+}
+
+void RenderUI(const SimState& state, ShaderVariants& shaders, Shader& textShader) {
+    // A) HUD: only touched when the mode or the distance at two decimals changes
+    hud.setSpriteTexture(hudIcon, state.isWalkingMode ? iconWalkTex.id() : iconMeasureTex.id());
+    if (state.isWalkingMode)
+        hud.setNumber(hudDistance, "Ukupna predjena distanca: ", state.totalWalkDistance, 2);
+    else
+        hud.setNumber(hudDistance, "Ukupna izmerena distanca: ", state.totalMeasuredLength, 2);
+    hud.draw();
+
+    // B) Debug pages, immediate
+    if (!showRenderStats && !showMemoryHud) return;
+    glm::mat4 uiProj = glm::ortho(0.0f, (float)SCR_WIDTH, 0.0f, (float)SCR_HEIGHT);
     glUseProgram(textShader.ID);
     glUniformMatrix4fv(glGetUniformLocation(textShader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(uiProj));
 
-    std::stringstream ss;
-    if (isWalkingMode) {
-        ss << "Ukupna predjena distanca: " << std::fixed << totalWalkDistance;
+    // Render queue statistics (previous flush)
+    if (showRenderStats) {
+        const RenderQueueStats& stats = renderQueue.stats();
+        std::stringstream rs;
+        rs << "Triangles: " << stats.triangles
+           << "  packets: " << stats.packets
+           << "  program " << stats.programBinds << " (-" << stats.programBindsSaved << ")"
+           << "  texture " << stats.textureBinds << " (-" << stats.textureBindsSaved << ")"
+           << "  vao " << stats.vaoBinds << " (-" << stats.vaoBindsSaved << ")"
+           << "  material " << stats.materialBinds << " (-" << stats.materialBindsSaved << ")"
+           << "  draws " << stats.drawCalls << " (+" << stats.mergedDraws << " merged)"
+           << "  normal mats " << stats.uniformScaleNormals << " uniform / " << stats.generalNormals << " general"
+           << "  variants " << shaders.compiledCount();
+        const PolylineStats& route = routeLines.stats();
+        const HudStats& hs = hud.stats();
+        const PolylineLodStats& routeLevels = routeLod.stats();
+        rs << "  route " << routeLevels.selected << "/" << routeLevels.points << " points, " << route.segments << " segments ("
+           << routeLevels.walks << " walks, " << routeLevels.reuses << " reused, " << route.uploads << " uploads)"
+           << "  hud " << hs.drawCalls << " draws, " << hs.vertices << " vtx, " << hs.rebuilds << " rebuilds";
+        BackgroundLoaderStats ls = backgroundLoaderStats();
+        if (ls.queuedJobs + ls.runningJobs + ls.pendingSteps > 0)
+            rs << "  loading " << ls.queuedJobs + ls.runningJobs << " jobs, " << ls.pendingSteps << " uploads (" << ls.lastWorkMs << " ms)";
+        RenderText(textShader.ID, rs.str(), 25.0f, 70.0f, 0.5f, 0.6f, 0.8f, 1.0f);
+
+        float poolY = 95.0f;
+        const SimPick& pick = state.lastPick;
+        if (pick.entity != SimEntity::None) {
+            const char* entityNames[] = { "none", "ground", "player", "pin" };
+            std::stringstream ps;
+            ps << std::fixed << std::setprecision(2) << "Last pick: " << entityNames[(int)pick.entity];
+            if (pick.entity == SimEntity::Pin) ps << " " << pick.index;
+            if (pick.entity == SimEntity::Player || pick.entity == SimEntity::Pin)
+                ps << "  mesh " << pick.mesh << " triangle " << pick.triangle << " (" << pick.barycentric.x << ", " << pick.barycentric.y << ")";
+            ps << "  at " << pick.point.x << ", " << pick.point.y << ", " << pick.point.z << "  in " << pick.microseconds << " us";
+            RenderText(textShader.ID, ps.str(), 25.0f, poolY, 0.5f, 0.6f, 0.8f, 1.0f);
+            poolY += 25.0f;
+        }
+
+        for (const GeometryPool* pool : geometryPools()) {
+            const GeometryPoolStats& ps = pool->stats();
+            std::stringstream gs;
+            gs << pool->name() << " pool: " << ps.allocations << " ranges  vtx " << ps.vertexUsed << "/" << ps.vertexCapacity
+               << "  idx " << ps.indexUsed << "/" << ps.indexCapacity << "  free blocks " << ps.freeBlocks << "  growths " << ps.growths;
+            RenderText(textShader.ID, gs.str(), 25.0f, poolY, 0.5f, 0.6f, 0.8f, 1.0f);
+            poolY += 25.0f;
+        }
     }
-    else {
-        ss << "Ukupna izmerena distanca: " << std::fixed << totalMeasuredLength;
+
+    // Memory page
+    if (showMemoryHud) {
+        std::vector<std::string> lines = resourceSummaryLines(12);
+        AssetStats assets = assetStats();
+        std::stringstream as;
+        as << "Assets: " << assets.loaded << " cached (" << assets.referenced << " in use)  loads " << assets.loads
+           << "  hits " << assets.keyHits << " by path / " << assets.contentHits << " by content  evicted " << assets.evictions << "  refined " << assets.refinements;
+        AssetPackStats pack = assetPackStats();
+        if (pack.entries > 0)
+            as << "  pack " << pack.views << " mapped / " << pack.decompressions << " lz4 / " << pack.looseReads << " loose";
+        lines.insert(lines.begin(), as.str());
+        float lineY = SCR_HEIGHT - 100.0f;
+        for (const std::string& line : lines) {
+            RenderText(textShader.ID, line, 25.0f, lineY, 0.5f, 0.6f, 1.0f, 0.6f);
+            lineY -= 28.0f;
+        }
     }
-    RenderText(textShader.ID, ss.str(), 25.0f, SCR_HEIGHT - 50.0f, 1.0f, 1.0f, 1.0f, 0.0f);
-    RenderText(textShader.ID, "Mijat Krivokapic SV41/2022", 25.0f, 25.0f, 1.0f, 1.0f, 1.0f, 0.0f);
 }
 
 // ----------------------------------------------------------------------------
 // LOGIC & INPUT
 // ----------------------------------------------------------------------------
-void ToggleMode() {
-    if (isWalkingMode) {
-        savedWalkPos = cameraPos;
-        isWalkingMode = false;
-        cameraPos = savedMeasurePos;
-    }
-    else {
-        // Switch to Walking
-        savedMeasurePos = cameraPos;
-        isWalkingMode = true;
-        cameraPos = savedWalkPos;
-    }
+// Game logic lives in Simulation.cpp; input is only translated into simulation events here
+void PushSimEvent(SimEventType type, uint64_t sequence, double x, double y) {
+    SimEvent event;
+    event.type = type;
+    event.heldKeys = sentHeldKeys;
+    event.x = x;
+    event.y = y;
+    event.sequence = sequence;
+    if (!simulation.pushEvent(event))
+        std::cout << "ERROR::SIMULATION::EVENT_QUEUE_FULL" << std::endl;
 }
 
 void ProcessInput(GLFWwindow* window) {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+    if (inputGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
-    float velocity = playerSpeed * deltaTime;
-    float camSpeed = 5.0f * deltaTime;
-
-    if (isWalkingMode) {
-        // Player Movement
-        glm::vec3 oldPos = playerPos;
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) { playerPos.z -= velocity; playerRotation = 180.0f; }
-        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) { playerPos.z += velocity; playerRotation = 0.0f; }
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) { playerPos.x -= velocity; playerRotation = -90.0f; }
-        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) { playerPos.x += velocity; playerRotation = 90.0f; }
-
-        // Bounds check
-        if (playerPos.x < -MAP_SIZE || playerPos.x > MAP_SIZE || playerPos.z < -MAP_SIZE || playerPos.z > MAP_SIZE)
-            playerPos = oldPos;
-    }
-
-    // Camera Movement
-    if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)    cameraPos.z -= camSpeed;
-    if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)  cameraPos.z += camSpeed;
-    if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)  cameraPos.x -= camSpeed;
-    if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) cameraPos.x += camSpeed;
-
-    // Camera Limits
-    if (cameraPos.x > MAP_SIZE) cameraPos.x = MAP_SIZE;
-    if (cameraPos.x < -MAP_SIZE) cameraPos.x = -MAP_SIZE;
-
-    if (isWalkingMode) {
-        if (cameraPos.z > 12.0f) cameraPos.z = 12.0f;
-        if (cameraPos.z < -8.0f) cameraPos.z = -8.0f;
-    }
-    else {
-        if (cameraPos.z > 20.0f) cameraPos.z = 20.0f;
-        if (cameraPos.z < 0.0f) cameraPos.z = 0.0f;
+    static const struct { int key; uint16_t bit; } heldKeyMap[] = {
+        { GLFW_KEY_W, SimKeyWalkForward }, { GLFW_KEY_S, SimKeyWalkBack },
+        { GLFW_KEY_A, SimKeyWalkLeft }, { GLFW_KEY_D, SimKeyWalkRight },
+        { GLFW_KEY_UP, SimKeyCameraUp }, { GLFW_KEY_DOWN, SimKeyCameraDown },
+        { GLFW_KEY_LEFT, SimKeyCameraLeft }, { GLFW_KEY_RIGHT, SimKeyCameraRight }
+    };
+    uint16_t heldKeys = 0;
+    for (const auto& mapping : heldKeyMap)
+        if (inputGetKey(window, mapping.key) == GLFW_PRESS) heldKeys |= mapping.bit;
+
+    // Also sent when only unrelated keys arrived, so the simulation acknowledges their sequence
+    uint64_t sequence = latestInputSequence();
+    if (heldKeys != sentHeldKeys || sequence != sentInputSequence) {
+        sentHeldKeys = heldKeys;
+        sentInputSequence = sequence;
+        PushSimEvent(SimEventType::HeldKeys, sequence);
     }
-    
-}
-
-// Helper: Performs Raycasting to find where the mouse clicks on the map (y=0)
-bool GetGroundIntersection(GLFWwindow* window, double mouseX, double mouseY, glm::vec3& outIntersection) {
-    // 1. Reconstruct Matrices
-    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-    glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, glm::vec3(0.0f, 1.0f, 0.0f));
-    glm::vec4 viewport = glm::vec4(0, 0, SCR_WIDTH, SCR_HEIGHT);
-
-    // 2. Unproject 2D mouse coordinates to 3D Ray
-    glm::vec3 winPosNear = glm::vec3(mouseX, SCR_HEIGHT - mouseY, 0.0f); // Near plane
-    glm::vec3 winPosFar = glm::vec3(mouseX, SCR_HEIGHT - mouseY, 1.0f); // Far plane
-
-    glm::vec3 rayStart = glm::unProject(winPosNear, view, projection, viewport);
-    glm::vec3 rayEnd = glm::unProject(winPosFar, view, projection, viewport);
-    glm::vec3 rayDir = glm::normalize(rayEnd - rayStart);
-
-    // 3. Find intersection with Plane Y=0
-    // formula: t = -start.y / dir.y
-    if (rayDir.y == 0.0f) return false;
-
-    float t = -rayStart.y / rayDir.y;
-    if (t < 0.0f) return false; // Intersection is behind camera
-
-    outIntersection = rayStart + rayDir * t;
-    return true;
 }
 
 void mouse_callback(GLFWwindow* window, int button, int action, int mods) {
-    if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS) return;
+    uint64_t sequence = onInputEvent(InputEventType::MouseButton, glfwGetTime());
 
     double xpos, ypos;
-    glfwGetCursorPos(window, &xpos, &ypos);
+    inputGetCursorPos(window, &xpos, &ypos);
+    recordMouseButtonEvent(button, action, mods, xpos, ypos);
 
-    // A. CHECK ICON CLICK
-    float iconLeft = SCR_WIDTH - (iconSize + iconPadding);
-    float iconRight = SCR_WIDTH - iconPadding;
-    float iconTop = iconPadding;
-    float iconBottom = iconPadding + iconSize;
-
-    if (xpos >= iconLeft && xpos <= iconRight && ypos >= iconTop && ypos <= iconBottom) {
-        ToggleMode();
-        return;
-    }
-
-    // B. CHECK MAP CLICK (Only in Measuring Mode)
-    if (!isWalkingMode) {
-        glm::vec3 hitPoint;
-        if (GetGroundIntersection(window, xpos, ypos, hitPoint)) {
-            // Check Map Bounds
-            if (hitPoint.x >= -MAP_SIZE && hitPoint.x <= MAP_SIZE && hitPoint.z >= -MAP_SIZE && hitPoint.z <= MAP_SIZE) {
-
-                // Logic: Delete if close to existing, else Add
-                bool deleted = false;
-                for (size_t i = 0; i < measurementPoints.size(); i++) {
-                    if (glm::distance(measurementPoints[i], hitPoint) < 0.5f) {
-                        measurementPoints.erase(measurementPoints.begin() + i);
-                        deleted = true;
-                        break;
-                    }
-                }
-
-                if (!deleted) {
-                    measurementPoints.push_back(hitPoint);
-                }
-
-                // Recalculate total length
-                totalMeasuredLength = 0.0f;
-                if (measurementPoints.size() > 1) {
-                    for (size_t i = 0; i < measurementPoints.size() - 1; i++) {
-                        totalMeasuredLength += glm::distance(measurementPoints[i], measurementPoints[i + 1]);
-                    }
-                }
-            }
-        }
-    }
+    // Icon and map clicks are resolved by the simulation against its own camera
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+        PushSimEvent(SimEventType::Click, sequence, xpos, ypos);
 }
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    uint64_t sequence = latestInputSequence();
+    if (action != GLFW_REPEAT)
+        sequence = onInputEvent(InputEventType::Key, glfwGetTime());
+    recordKeyEvent(key, scancode, action, mods);
+
     if (key == GLFW_KEY_R && action == GLFW_PRESS) {
-        ToggleMode();
+        PushSimEvent(SimEventType::ToggleMode, sequence);
     }
 
     if (key == GLFW_KEY_N && action == GLFW_PRESS) {
@@ -534,6 +814,22 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
         std::cout << "Depth Test: " << (depthTestEnabled ? "ON" : "OFF") << std::endl;
     }
 
+    if (key == GLFW_KEY_F1 && action == GLFW_PRESS) {
+        showMemoryHud = !showMemoryHud;
+    }
+
+    if (key == GLFW_KEY_F2 && action == GLFW_PRESS) {
+        dumpResourcesJson(resourceDumpPath);
+    }
+
+    if (key == GLFW_KEY_F3 && action == GLFW_PRESS) {
+        std::cout << inputLatencySummary() << std::endl;
+    }
+
+    if (key == GLFW_KEY_F4 && action == GLFW_PRESS) {
+        showRenderStats = !showRenderStats;
+    }
+
     // Taster M za Face Culling
     if (key == GLFW_KEY_M && action == GLFW_PRESS) {
         faceCullingEnabled = !faceCullingEnabled;
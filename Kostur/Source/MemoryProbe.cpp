@@ -0,0 +1,142 @@
+#include "../Header/MemoryProbe.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#define PSAPI_VERSION 2     // GetProcessMemoryInfo from kernel32, no psapi.lib
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#ifdef MEMORY_PROBE_COUNT_ALLOCATIONS
+
+static std::atomic<size_t> allocations(0);
+static std::atomic<size_t> allocationBytes(0);
+
+void* operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+// the array, nothrow and sized forms all forward to these two
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+bool countingAllocations()
+{
+    return true;
+}
+
+size_t allocationCount()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+size_t allocatedBytes()
+{
+    return allocationBytes.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool countingAllocations()
+{
+    return false;
+}
+
+size_t allocationCount()
+{
+    return 0;
+}
+
+size_t allocatedBytes()
+{
+    return 0;
+}
+
+#endif
+
+#ifdef _WIN32
+
+size_t peakResidentBytes()
+{
+    PROCESS_MEMORY_COUNTERS counters = {};
+    return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize : 0;
+}
+
+#else
+
+size_t peakResidentBytes()
+{
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;             // bytes
+#else
+    return (size_t)usage.ru_maxrss * 1024;      // kilobytes
+#endif
+}
+
+#endif
+
+bool appendLoadBenchmark(const char* path, const std::string& label, const std::string& model, double ms,
+                         size_t allocationsMade, size_t bytes, size_t peakRss, size_t keptBytes)
+{
+    {
+        std::ofstream file(path, std::ios::app);
+        if (!file.is_open()) {
+            std::cout << "ERROR::LOAD_BENCH:: unable to write " << path << std::endl;
+            return false;
+        }
+        file << std::fixed << std::setprecision(3) << label << "," << model << "," << ms << "," << allocationsMade << ","
+             << bytes / 1024 << "," << peakRss / 1024 << "," << keptBytes / 1024 << "\n";
+    }
+
+    // Summarize every run recorded so far, grouped by label and model
+    struct Totals { double ms = 0.0, allocations = 0.0, allocatedKB = 0.0, peakKB = 0.0, keptKB = 0.0; int runs = 0; };
+    std::map<std::string, Totals> totals;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        std::vector<std::string> fields;
+        std::string field;
+        while (std::getline(ss, field, ',')) fields.push_back(field);
+        if (fields.size() != 7) continue;
+        Totals& t = totals[fields[0] + " " + fields[1]];
+        // strtod rather than stod: a damaged line counts as zeros instead of throwing
+        t.ms += std::strtod(fields[2].c_str(), nullptr);
+        t.allocations += std::strtod(fields[3].c_str(), nullptr);
+        t.allocatedKB += std::strtod(fields[4].c_str(), nullptr);
+        t.peakKB += std::strtod(fields[5].c_str(), nullptr);
+        t.keptKB += std::strtod(fields[6].c_str(), nullptr);
+        t.runs++;
+    }
+
+    std::cout << std::fixed << std::setprecision(1);
+    for (const auto& entry : totals) {
+        const Totals& t = entry.second;
+        std::cout << "Load benchmark [" << entry.first << "]: " << t.runs << " runs, avg " << t.ms / t.runs << " ms, "
+                  << t.allocations / t.runs << " allocations (" << t.allocatedKB / t.runs / 1024.0 << " MB), peak RSS "
+                  << t.peakKB / t.runs / 1024.0 << " MB, " << t.keptKB / t.runs / 1024.0 << " MB CPU mesh data kept" << std::endl;
+    }
+    std::cout << std::defaultfloat;
+    return true;
+}
@@ -0,0 +1,256 @@
+#include "../Header/MeshBvh.h"
+
+#include <algorithm>
+#include <cmath>
+
+// relative cost of descending into a node against testing one triangle
+static const float TRAVERSAL_COST = 1.0f;
+static const float TRIANGLE_COST = 1.0f;
+static const int TRAVERSAL_STACK = 64;
+
+namespace {
+
+struct Box {
+    glm::vec3 lo = glm::vec3(FLT_MAX), hi = glm::vec3(-FLT_MAX);
+
+    void grow(const glm::vec3& p) { lo = glm::min(lo, p); hi = glm::max(hi, p); }
+    void grow(const Box& b) { lo = glm::min(lo, b.lo); hi = glm::max(hi, b.hi); }
+    float area() const
+    {
+        if (lo.x > hi.x) return 0.0f;
+        glm::vec3 e = hi - lo;
+        return e.x * e.y + e.y * e.z + e.z * e.x;
+    }
+};
+
+struct Bin {
+    Box bounds;
+    unsigned int count = 0;
+};
+
+struct BuildTask {
+    unsigned int node, first, count;
+};
+
+}
+
+void MeshBvh::build(const float* positions, size_t positionStride, const unsigned int* indices, size_t triangleCount)
+{
+    nodes.clear();
+    corners.clear();
+    triangleIds.clear();
+    if (triangleCount == 0) return;
+
+    // per triangle bounds and centroid
+    std::vector<Box> boxes(triangleCount);
+    std::vector<glm::vec3> centroids(triangleCount);
+    std::vector<unsigned int> order(triangleCount);
+    for (size_t i = 0; i < triangleCount; i++) {
+        for (int k = 0; k < 3; k++) {
+            const float* p = (const float*)((const char*)positions + indices[3 * i + k] * positionStride);
+            boxes[i].grow(glm::vec3(p[0], p[1], p[2]));
+        }
+        centroids[i] = (boxes[i].lo + boxes[i].hi) * 0.5f;
+        order[i] = (unsigned int)i;
+    }
+
+    nodes.reserve(2 * triangleCount);   // a binary tree over leaves of at least one triangle
+    nodes.push_back(Node());
+    std::vector<BuildTask> tasks;
+    tasks.push_back({ 0, 0, (unsigned int)triangleCount });
+
+    while (!tasks.empty()) {
+        BuildTask task = tasks.back();
+        tasks.pop_back();
+
+        Box bounds, centroidBounds;
+        for (unsigned int i = task.first; i < task.first + task.count; i++) {
+            bounds.grow(boxes[order[i]]);
+            centroidBounds.grow(centroids[order[i]]);
+        }
+        Node& node = nodes[task.node];
+        node.boundsMin = bounds.lo;
+        node.boundsMax = bounds.hi;
+        node.first = task.first;
+        node.count = task.count;
+        if (task.count <= 2) continue;
+
+        // best binned split over all three axes
+        float leafCost = TRIANGLE_COST * task.count;
+        float bestCost = FLT_MAX;
+        int bestAxis = -1, bestSplit = 0;
+        for (int axis = 0; axis < 3; axis++) {
+            float lo = centroidBounds.lo[axis], extent = centroidBounds.hi[axis] - lo;
+            if (extent <= 0.0f) continue;
+            float scale = BVH_SAH_BINS / extent;
+
+            Bin bins[BVH_SAH_BINS];
+            for (unsigned int i = task.first; i < task.first + task.count; i++) {
+                int b = std::min(BVH_SAH_BINS - 1, (int)((centroids[order[i]][axis] - lo) * scale));
+                bins[b].bounds.grow(boxes[order[i]]);
+                bins[b].count++;
+            }
+
+            // sweep from the right to get every right-side area, then from the left to price each split
+            float rightArea[BVH_SAH_BINS];
+            unsigned int rightCount[BVH_SAH_BINS];
+            Box right;
+            unsigned int count = 0;
+            for (int b = BVH_SAH_BINS - 1; b > 0; b--) {
+                right.grow(bins[b].bounds);
+                count += bins[b].count;
+                rightArea[b] = right.area();
+                rightCount[b] = count;
+            }
+            Box left;
+            count = 0;
+            for (int b = 0; b < BVH_SAH_BINS - 1; b++) {
+                left.grow(bins[b].bounds);
+                count += bins[b].count;
+                if (count == 0 || rightCount[b + 1] == 0) continue;
+                float cost = left.area() * count + rightArea[b + 1] * rightCount[b + 1];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b + 1;
+                }
+            }
+        }
+
+        // SAH: probability of visiting a child is its area relative to the parent's
+        float parentArea = bounds.area();
+        if (bestAxis < 0) continue;
+        float splitCost = parentArea > 0.0f ? TRAVERSAL_COST + TRIANGLE_COST * bestCost / parentArea : leafCost;
+        if (splitCost >= leafCost && task.count <= BVH_MAX_LEAF_TRIANGLES) continue;
+
+        float lo = centroidBounds.lo[bestAxis];
+        float scale = BVH_SAH_BINS / (centroidBounds.hi[bestAxis] - lo);
+        unsigned int* middle = std::partition(order.data() + task.first, order.data() + task.first + task.count, [&](unsigned int t) {
+            return std::min(BVH_SAH_BINS - 1, (int)((centroids[t][bestAxis] - lo) * scale)) < bestSplit;
+        });
+        unsigned int leftCount = (unsigned int)(middle - (order.data() + task.first));
+
+        unsigned int leftChild = (unsigned int)nodes.size();
+        nodes[task.node].first = leftChild;
+        nodes[task.node].count = 0;
+        nodes.push_back(Node());
+        nodes.push_back(Node());
+        tasks.push_back({ leftChild, task.first, leftCount });
+        tasks.push_back({ leftChild + 1, task.first + leftCount, task.count - leftCount });
+    }
+    nodes.shrink_to_fit();
+
+    // triangles in leaf order, so a leaf reads one contiguous run
+    corners.resize(3 * triangleCount);
+    triangleIds = order;
+    for (size_t i = 0; i < triangleCount; i++)
+        for (int k = 0; k < 3; k++) {
+            const float* p = (const float*)((const char*)positions + indices[3 * order[i] + k] * positionStride);
+            corners[3 * i + k] = glm::vec3(p[0], p[1], p[2]);
+        }
+}
+
+bool intersectRayBox(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& boxMin, const glm::vec3& boxMax,
+                     float maxT, float& entryT)
+{
+    glm::vec3 t0 = (boxMin - origin) * inverseDirection;
+    glm::vec3 t1 = (boxMax - origin) * inverseDirection;
+    glm::vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+    float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxT));
+    entryT = enter;
+    return enter <= exit;
+}
+
+// Moller-Trumbore, both faces
+static bool intersectTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3* v, float maxT,
+                              float& t, float& u, float& w)
+{
+    glm::vec3 e1 = v[1] - v[0], e2 = v[2] - v[0];
+    glm::vec3 p = glm::cross(direction, e2);
+    float det = glm::dot(e1, p);
+    if (std::fabs(det) < 1e-12f) return false;
+    float inverse = 1.0f / det;
+
+    glm::vec3 s = origin - v[0];
+    u = glm::dot(s, p) * inverse;
+    if (u < 0.0f || u > 1.0f) return false;
+    glm::vec3 q = glm::cross(s, e1);
+    w = glm::dot(direction, q) * inverse;
+    if (w < 0.0f || u + w > 1.0f) return false;
+    t = glm::dot(e2, q) * inverse;
+    return t > 0.0f && t < maxT;
+}
+
+bool MeshBvh::intersect(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit) const
+{
+    if (nodes.empty()) return false;
+    // 1/0 gives +-inf, which the slab test handles; only 0 * inf (origin on a slab) needs care
+    glm::vec3 inverseDirection = 1.0f / direction;
+
+    float entry;
+    if (!intersectRayBox(origin, inverseDirection, nodes[0].boundsMin, nodes[0].boundsMax, hit.t, entry)) return false;
+
+    unsigned int stack[TRAVERSAL_STACK];
+    int top = 0;
+    stack[top++] = 0;
+    bool found = false;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (node.count > 0) {
+            for (unsigned int i = node.first; i < node.first + node.count; i++) {
+                float t, u, w;
+                if (!intersectTriangle(origin, direction, &corners[3 * i], hit.t, t, u, w)) continue;
+                hit.t = t;
+                hit.triangle = triangleIds[i];
+                hit.barycentric = glm::vec2(u, w);
+                found = true;
+            }
+            continue;
+        }
+
+        // visit the nearer child first, so the farther one is often culled by the hit it finds
+        float leftEntry, rightEntry;
+        const Node& left = nodes[node.first];
+        const Node& right = nodes[node.first + 1];
+        bool hitLeft = intersectRayBox(origin, inverseDirection, left.boundsMin, left.boundsMax, hit.t, leftEntry);
+        bool hitRight = intersectRayBox(origin, inverseDirection, right.boundsMin, right.boundsMax, hit.t, rightEntry);
+        if (hitLeft && hitRight && top + 2 <= TRAVERSAL_STACK) {
+            bool leftFirst = leftEntry <= rightEntry;
+            stack[top++] = leftFirst ? node.first + 1 : node.first;
+            stack[top++] = leftFirst ? node.first : node.first + 1;
+        }
+        else if (hitLeft && top < TRAVERSAL_STACK)
+            stack[top++] = node.first;
+        else if (hitRight && top < TRAVERSAL_STACK)
+            stack[top++] = node.first + 1;
+    }
+    return found;
+}
+
+size_t MeshBvh::bytes() const
+{
+    return nodes.capacity() * sizeof(Node) + corners.capacity() * sizeof(glm::vec3) + triangleIds.capacity() * sizeof(unsigned int);
+}
+
+bool ModelBvh::intersect(const glm::vec3& origin, const glm::vec3& direction, RayHit& hit) const
+{
+    float entry;
+    if (!intersectRayBox(origin, 1.0f / direction, boundsMin, boundsMax, hit.t, entry)) return false;
+
+    bool found = false;
+    for (unsigned int i = 0; i < meshes.size(); i++) {
+        if (meshes[i].intersect(origin, direction, hit)) {
+            hit.mesh = i;
+            found = true;
+        }
+    }
+    return found;
+}
+
+size_t ModelBvh::bytes() const
+{
+    size_t total = 0;
+    for (const MeshBvh& mesh : meshes) total += mesh.bytes();
+    return total;
+}
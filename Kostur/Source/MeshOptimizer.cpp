@@ -0,0 +1,219 @@
+#include "../Header/MeshOptimizer.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize)
+{
+    VertexCacheStats stats;
+    if (indices.empty() || vertexCount == 0) return stats;
+
+    // FIFO: a vertex is in the cache if it was inserted within the last cacheSize misses
+    std::vector<unsigned int> insertedAt(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    unsigned int misses = 0;
+    size_t unique = 0;
+    for (unsigned int index : indices) {
+        if (!referenced[index]) {
+            referenced[index] = true;
+            unique++;
+        }
+        if (insertedAt[index] == 0 || misses - insertedAt[index] >= cacheSize) {
+            misses++;
+            insertedAt[index] = misses;
+        }
+    }
+
+    stats.acmr = (float)misses / (float)(indices.size() / 3);
+    stats.atvr = (float)misses / (float)unique;
+    return stats;
+}
+
+// --- Tipsify ---
+
+static int skipDeadEnd(const std::vector<unsigned int>& liveTriangles, std::vector<unsigned int>& deadEnds, size_t& cursor, size_t vertexCount)
+{
+    // most recently touched vertices first, they are the likeliest to still be cached
+    while (!deadEnds.empty()) {
+        unsigned int d = deadEnds.back();
+        deadEnds.pop_back();
+        if (liveTriangles[d] > 0) return (int)d;
+    }
+    // otherwise the next vertex in input order that still has work left
+    for (; cursor < vertexCount; cursor++)
+        if (liveTriangles[cursor] > 0) return (int)cursor;
+    return -1;
+}
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || indices.size() % 3 != 0) return;
+
+    // vertex -> triangle adjacency, as offsets into one flat list
+    std::vector<unsigned int> liveTriangles(vertexCount, 0);
+    for (unsigned int index : indices) liveTriangles[index]++;
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + liveTriangles[v];
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++)
+        for (int k = 0; k < 3; k++)
+            adjacency[fill[indices[t * 3 + k]]++] = (unsigned int)t;
+
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> deadEnds;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+
+    unsigned int timestamp = cacheSize + 1;
+    size_t cursor = 0;
+    int fanning = skipDeadEnd(liveTriangles, deadEnds, cursor, vertexCount);
+
+    while (fanning >= 0) {
+        candidates.clear();
+
+        // emit every remaining triangle around the fanning vertex
+        for (unsigned int a = offsets[fanning]; a < offsets[fanning + 1]; a++) {
+            unsigned int t = adjacency[a];
+            if (emitted[t]) continue;
+            emitted[t] = true;
+            for (int k = 0; k < 3; k++) {
+                unsigned int v = indices[t * 3 + k];
+                output.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+                if (timestamp - cacheTime[v] > cacheSize) {
+                    cacheTime[v] = timestamp;
+                    timestamp++;
+                }
+            }
+        }
+
+        // next fan: the candidate that will still be cached after its own triangles are emitted, oldest first
+        int next = -1;
+        int bestPriority = -1;
+        for (unsigned int v : candidates) {
+            if (liveTriangles[v] == 0) continue;
+            int priority = 0;
+            if (timestamp - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+                priority = (int)(timestamp - cacheTime[v]);
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = (int)v;
+            }
+        }
+        if (next < 0) next = skipDeadEnd(liveTriangles, deadEnds, cursor, vertexCount);
+        fanning = next;
+    }
+
+    indices.swap(output);
+}
+
+// --- overdraw ---
+
+void optimizeOverdraw(std::vector<unsigned int>& indices, const float* positions, size_t positionStride, size_t vertexCount,
+                      float threshold, unsigned int cacheSize)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2 || indices.size() % 3 != 0) return;
+
+    auto position = [&](unsigned int v) {
+        const float* p = (const float*)((const char*)positions + v * positionStride);
+        return glm::vec3(p[0], p[1], p[2]);
+    };
+
+    // hard cluster boundaries: triangles whose three vertices all miss the cache.
+    // the cache is cold there anyway, so reordering whole clusters costs little ACMR
+    std::vector<size_t> clusterStarts;
+    {
+        std::vector<unsigned int> insertedAt(vertexCount, 0);
+        unsigned int misses = 0;
+        for (size_t t = 0; t < triangleCount; t++) {
+            int triangleMisses = 0;
+            for (int k = 0; k < 3; k++) {
+                unsigned int v = indices[t * 3 + k];
+                if (insertedAt[v] == 0 || misses - insertedAt[v] >= cacheSize) {
+                    misses++;
+                    insertedAt[v] = misses;
+                    triangleMisses++;
+                }
+            }
+            if (t == 0 || triangleMisses == 3) clusterStarts.push_back(t);
+        }
+    }
+    if (clusterStarts.size() < 2) return;
+
+    // mesh centroid, area weighted
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t t = 0; t < triangleCount; t++) {
+        glm::vec3 a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), c = position(indices[t * 3 + 2]);
+        float area = glm::length(glm::cross(b - a, c - a));
+        meshCentroid += (a + b + c) * (area / 3.0f);
+        meshArea += area;
+    }
+    if (meshArea > 0.0f) meshCentroid /= meshArea;
+
+    // sort key: clusters far out along their own facing direction are likely to occlude the rest
+    struct Cluster {
+        size_t first, count;
+        float key;
+    };
+    std::vector<Cluster> clusters;
+    for (size_t i = 0; i < clusterStarts.size(); i++) {
+        Cluster cluster;
+        cluster.first = clusterStarts[i];
+        cluster.count = (i + 1 < clusterStarts.size() ? clusterStarts[i + 1] : triangleCount) - cluster.first;
+
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t t = cluster.first; t < cluster.first + cluster.count; t++) {
+            glm::vec3 a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), c = position(indices[t * 3 + 2]);
+            glm::vec3 n = glm::cross(b - a, c - a);
+            float triangleArea = glm::length(n);
+            centroid += (a + b + c) * (triangleArea / 3.0f);
+            normal += n;
+            area += triangleArea;
+        }
+        if (area > 0.0f) centroid /= area;
+        float normalLength = glm::length(normal);
+        cluster.key = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.0f;
+        clusters.push_back(cluster);
+    }
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.key > b.key; });
+
+    std::vector<unsigned int> sorted;
+    sorted.reserve(indices.size());
+    for (const Cluster& cluster : clusters)
+        sorted.insert(sorted.end(), indices.begin() + cluster.first * 3, indices.begin() + (cluster.first + cluster.count) * 3);
+
+    float before = analyzeVertexCache(indices, vertexCount, cacheSize).acmr;
+    float after = analyzeVertexCache(sorted, vertexCount, cacheSize).acmr;
+    if (after <= before * threshold)
+        indices.swap(sorted);
+}
+
+// --- vertex fetch ---
+
+std::vector<unsigned int> optimizeVertexFetch(std::vector<unsigned int>& indices, size_t vertexCount)
+{
+    const unsigned int unassigned = ~0u;
+    std::vector<unsigned int> newIndex(vertexCount, unassigned);
+    std::vector<unsigned int> remap;
+    remap.reserve(vertexCount);
+
+    for (unsigned int& index : indices) {
+        if (newIndex[index] == unassigned) {
+            newIndex[index] = (unsigned int)remap.size();
+            remap.push_back(index);
+        }
+        index = newIndex[index];
+    }
+    return remap;
+}
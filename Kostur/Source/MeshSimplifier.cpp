@@ -0,0 +1,251 @@
+#include "../Header/MeshSimplifier.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+namespace {
+
+// symmetric 4x4 plane quadric, upper triangle
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+    double a11 = 0, a12 = 0, a13 = 0;
+    double a22 = 0, a23 = 0;
+    double a33 = 0;
+    double weight = 0;  // total plane weight, so the error is an average squared distance
+
+    void addPlane(double a, double b, double c, double d, double weight)
+    {
+        a00 += weight * a * a; a01 += weight * a * b; a02 += weight * a * c; a03 += weight * a * d;
+        a11 += weight * b * b; a12 += weight * b * c; a13 += weight * b * d;
+        a22 += weight * c * c; a23 += weight * c * d;
+        a33 += weight * d * d;
+        this->weight += weight;
+    }
+
+    void add(const Quadric& q)
+    {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+        a11 += q.a11; a12 += q.a12; a13 += q.a13;
+        a22 += q.a22; a23 += q.a23;
+        a33 += q.a33;
+        weight += q.weight;
+    }
+
+    // weighted mean squared distance of a point to the accumulated planes
+    double error(const glm::vec3& p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double e = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x
+                 + a11 * y * y + 2 * a12 * y * z + 2 * a13 * y
+                 + a22 * z * z + 2 * a23 * z
+                 + a33;
+        return e > 0 && weight > 0 ? e / weight : 0;
+    }
+};
+
+struct Collapse {
+    unsigned int from, to;
+    double cost;
+};
+
+uint64_t edgeKey(unsigned int a, unsigned int b)
+{
+    if (a > b) std::swap(a, b);
+    return ((uint64_t)a << 32) | b;
+}
+
+glm::vec3 triangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+    return glm::cross(b - a, c - a);
+}
+
+}
+
+std::vector<unsigned int> simplifyMesh(const std::vector<unsigned int>& indices, const float* positions, size_t positionStride,
+                                       size_t vertexCount, size_t targetIndexCount, float maxError, float* resultError,
+                                       const float* uvs, size_t uvStride, const unsigned int* materials)
+{
+    if (resultError) *resultError = 0.0f;
+    std::vector<unsigned int> current = indices;
+    if (indices.size() % 3 != 0 || indices.size() <= targetIndexCount) return current;
+
+    std::vector<glm::vec3> position(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        const float* p = (const float*)((const char*)positions + v * positionStride);
+        position[v] = glm::vec3(p[0], p[1], p[2]);
+    }
+
+    // 1. weld by position: group[v] is the first vertex at v's position, and members lists every group's vertices
+    std::vector<unsigned int> group(vertexCount);
+    std::vector<unsigned int> memberOffsets(vertexCount + 1, 0), members(vertexCount);
+    {
+        std::map<std::tuple<float, float, float>, unsigned int> firstAt;
+        for (size_t v = 0; v < vertexCount; v++) {
+            auto inserted = firstAt.insert(std::make_pair(std::make_tuple(position[v].x, position[v].y, position[v].z), (unsigned int)v));
+            group[v] = inserted.first->second;
+            memberOffsets[group[v] + 1]++;
+        }
+        for (size_t v = 0; v < vertexCount; v++) memberOffsets[v + 1] += memberOffsets[v];
+        std::vector<unsigned int> fill(memberOffsets.begin(), memberOffsets.end() - 1);
+        for (size_t v = 0; v < vertexCount; v++) members[fill[group[v]]++] = (unsigned int)v;
+    }
+
+    // seams: moving a group whose members disagree on UV or material would tear the texture apart.
+    // members that differ only in their normal (creases) move together instead
+    std::vector<bool> locked(vertexCount, false);   // indexed by group
+    for (size_t v = 0; v < vertexCount; v++) {
+        unsigned int g = group[v];
+        if (g == v) continue;
+        if (materials && materials[v] != materials[g]) locked[g] = true;
+        if (uvs) {
+            const float* a = (const float*)((const char*)uvs + v * uvStride);
+            const float* b = (const float*)((const char*)uvs + g * uvStride);
+            if (a[0] != b[0] || a[1] != b[1]) locked[g] = true;
+        }
+    }
+
+    // 2. open borders: welded edges used by a single triangle
+    {
+        std::unordered_map<uint64_t, int> edgeUse;
+        for (size_t i = 0; i < current.size(); i += 3)
+            for (int k = 0; k < 3; k++)
+                edgeUse[edgeKey(group[current[i + k]], group[current[i + (k + 1) % 3]])]++;
+        for (size_t i = 0; i < current.size(); i += 3)
+            for (int k = 0; k < 3; k++) {
+                unsigned int a = group[current[i + k]], b = group[current[i + (k + 1) % 3]];
+                if (edgeUse[edgeKey(a, b)] == 1) locked[a] = locked[b] = true;
+            }
+    }
+
+    // 3. plane quadrics per group, area weighted
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < current.size(); i += 3) {
+        glm::vec3 n = triangleNormal(position[current[i]], position[current[i + 1]], position[current[i + 2]]);
+        float area = glm::length(n);
+        if (area <= 0.0f) continue;
+        n /= area;
+        double d = -glm::dot(n, position[current[i]]);
+        for (int k = 0; k < 3; k++)
+            quadrics[group[current[i + k]]].addPlane(n.x, n.y, n.z, d, area * 0.5);
+    }
+
+    double maxCost = (double)maxError * maxError;
+    double worstCost = 0.0;
+    std::vector<Collapse> collapses;
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);         // indexed by group
+    std::vector<unsigned int> target(vertexCount);
+    std::vector<unsigned int> triangleOffsets(vertexCount + 1), triangleList;
+
+    // 4. passes of independent group collapses, cheapest first, until the target is met or nothing is cheap enough
+    while (current.size() > targetIndexCount) {
+        collapses.clear();
+        for (size_t i = 0; i < current.size(); i += 3)
+            for (int k = 0; k < 3; k++) {
+                unsigned int a = group[current[i + k]], b = group[current[i + (k + 1) % 3]];
+                if (a == b) continue;
+                if (!locked[a]) {
+                    Quadric q = quadrics[a];
+                    q.add(quadrics[b]);
+                    collapses.push_back({ a, b, q.error(position[b]) });
+                }
+                if (!locked[b]) {
+                    Quadric q = quadrics[b];
+                    q.add(quadrics[a]);
+                    collapses.push_back({ b, a, q.error(position[a]) });
+                }
+            }
+        if (collapses.empty()) break;
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        // vertex -> triangle adjacency for this pass
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+        for (unsigned int index : current) triangleOffsets[index + 1]++;
+        for (size_t v = 0; v < vertexCount; v++) triangleOffsets[v + 1] += triangleOffsets[v];
+        triangleList.assign(current.size(), 0);
+        std::vector<unsigned int> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (size_t i = 0; i < current.size(); i++) triangleList[fill[current[i]]++] = (unsigned int)(i / 3);
+
+        for (size_t v = 0; v < vertexCount; v++) remap[v] = (unsigned int)v;
+        std::fill(touched.begin(), touched.end(), false);
+
+        size_t remaining = current.size();
+        unsigned int applied = 0;
+        for (const Collapse& collapse : collapses) {
+            if (remaining <= targetIndexCount || collapse.cost > maxCost) break;
+            if (touched[collapse.from] || touched[collapse.to]) continue;
+
+            // every member of the moving group goes to the member of the target group it shares a triangle
+            // with (the same side of a crease); a member without one can only go to a target with one member
+            bool valid = true;
+            for (unsigned int m = memberOffsets[collapse.from]; m < memberOffsets[collapse.from + 1] && valid; m++) {
+                unsigned int from = members[m];
+                target[from] = memberOffsets[collapse.to + 1] - memberOffsets[collapse.to] == 1 ? collapse.to : (unsigned int)-1;
+                for (unsigned int a = triangleOffsets[from]; a < triangleOffsets[from + 1]; a++) {
+                    const unsigned int* t = &current[triangleList[a] * 3];
+                    for (int k = 0; k < 3; k++)
+                        if (group[t[k]] == collapse.to) target[from] = t[k];
+                }
+                valid = target[from] != (unsigned int)-1 || triangleOffsets[from] == triangleOffsets[from + 1];
+            }
+            if (!valid) continue;
+
+            // reject collapses that would flip a triangle around the moving group
+            bool flips = false;
+            size_t removed = 0;
+            for (unsigned int m = memberOffsets[collapse.from]; m < memberOffsets[collapse.from + 1] && !flips; m++) {
+                unsigned int from = members[m];
+                for (unsigned int a = triangleOffsets[from]; a < triangleOffsets[from + 1] && !flips; a++) {
+                    const unsigned int* t = &current[triangleList[a] * 3];
+                    if (group[t[0]] == collapse.to || group[t[1]] == collapse.to || group[t[2]] == collapse.to) {
+                        removed += 3;
+                        continue;
+                    }
+                    glm::vec3 before = triangleNormal(position[t[0]], position[t[1]], position[t[2]]);
+                    glm::vec3 p[3];
+                    for (int k = 0; k < 3; k++) p[k] = group[t[k]] == collapse.from ? position[collapse.to] : position[t[k]];
+                    glm::vec3 after = triangleNormal(p[0], p[1], p[2]);
+                    if (glm::dot(before, after) <= 0.0f) flips = true;
+                }
+            }
+            if (flips) continue;
+
+            for (unsigned int m = memberOffsets[collapse.from]; m < memberOffsets[collapse.from + 1]; m++)
+                if (target[members[m]] != (unsigned int)-1) remap[members[m]] = target[members[m]];
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            worstCost = std::max(worstCost, collapse.cost);
+            remaining -= removed;
+            applied++;
+
+            // the whole one-ring changes shape, so it waits for the next pass
+            touched[collapse.from] = touched[collapse.to] = true;
+            for (unsigned int m = memberOffsets[collapse.from]; m < memberOffsets[collapse.from + 1]; m++) {
+                unsigned int from = members[m];
+                for (unsigned int a = triangleOffsets[from]; a < triangleOffsets[from + 1]; a++)
+                    for (int k = 0; k < 3; k++) touched[group[current[triangleList[a] * 3 + k]]] = true;
+            }
+        }
+        if (applied == 0) break;
+
+        // apply the pass and drop triangles that became degenerate (two corners in one group)
+        std::vector<unsigned int> next;
+        next.reserve(current.size());
+        for (size_t i = 0; i < current.size(); i += 3) {
+            unsigned int a = remap[current[i]], b = remap[current[i + 1]], c = remap[current[i + 2]];
+            if (group[a] == group[b] || group[b] == group[c] || group[a] == group[c]) continue;
+            next.push_back(a);
+            next.push_back(b);
+            next.push_back(c);
+        }
+        current.swap(next);
+    }
+
+    if (resultError) *resultError = (float)std::sqrt(worstCost);
+    return current;
+}
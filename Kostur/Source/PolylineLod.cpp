@@ -0,0 +1,149 @@
+#include "../Header/PolylineLod.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <utility>
+
+
+// distance of p from the box, 0 inside it
+static float boxDistance(const glm::vec3& p, const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+    glm::vec3 outside = glm::max(glm::max(boxMin - p, p - boxMax), glm::vec3(0.0f));
+    return glm::length(outside);
+}
+
+int32_t PolylineLod::addNode(uint32_t first, uint32_t last)
+{
+    if (last - first < 2) return -1;
+
+    Node node;
+    node.first = first;
+    node.last = last;
+    node.split = first + 1;
+    node.left = node.right = -1;
+
+    // farthest point from the chord (the segment first-last), compared squared
+    const glm::vec3 start = points[first];
+    const glm::vec3 chord = points[last] - start;
+    float chordSquared = glm::dot(chord, chord);
+    float inverseChord = chordSquared > 0.0f ? 1.0f / chordSquared : 0.0f;
+    float farthest = -1.0f;
+    for (uint32_t i = first + 1; i < last; i++) {
+        glm::vec3 offset = points[i] - start;
+        float t = std::min(std::max(glm::dot(offset, chord) * inverseChord, 0.0f), 1.0f);
+        glm::vec3 away = offset - chord * t;
+        float distanceSquared = glm::dot(away, away);
+        if (distanceSquared > farthest) {
+            farthest = distanceSquared;
+            node.split = i;
+        }
+    }
+    node.error = std::sqrt(farthest);
+    node.boundsMin = glm::min(glm::min(points[first], points[last]), points[node.split]);
+    node.boundsMax = glm::max(glm::max(points[first], points[last]), points[node.split]);
+    nodes.push_back(node);
+    return (int32_t)nodes.size() - 1;
+}
+
+void PolylineLod::build(const std::vector<glm::vec3>& source)
+{
+    points = source;
+    nodes.clear();
+    selected.clear();
+    walked = false;
+    selectionRevision++;
+
+    if (points.size() >= 2) {
+        // top down, with an explicit stack: long tracks split thousands of levels deep in the worst case
+        nodes.reserve(points.size());
+        std::vector<int32_t> pending;
+        if (addNode(0, (uint32_t)points.size() - 1) >= 0) pending.push_back(0);
+        while (!pending.empty()) {
+            int32_t index = pending.back();
+            pending.pop_back();
+            uint32_t first = nodes[index].first, split = nodes[index].split, last = nodes[index].last;
+            int32_t left = addNode(first, split);
+            int32_t right = addNode(split, last);
+            nodes[index].left = left;
+            nodes[index].right = right;
+            if (left >= 0) pending.push_back(left);
+            if (right >= 0) pending.push_back(right);
+        }
+
+        // bottom up: children come after their parent, so a reverse pass sees every subtree complete
+        for (size_t i = nodes.size(); i-- > 0; ) {
+            Node& node = nodes[i];
+            for (int32_t child : { node.left, node.right }) {
+                if (child < 0) continue;
+                node.error = std::max(node.error, nodes[child].error);
+                node.boundsMin = glm::min(node.boundsMin, nodes[child].boundsMin);
+                node.boundsMax = glm::max(node.boundsMax, nodes[child].boundsMax);
+            }
+        }
+    }
+
+    lodStats.points = points.size();
+    lodStats.nodes = nodes.size();
+    lodStats.selected = 0;
+}
+
+void PolylineLod::walk(const glm::vec3& viewPos, float threshold, std::vector<uint32_t>& indices, float& slack) const
+{
+    // in order (everything left of a split, the split, everything right of it), with an explicit
+    // stack like build. An entry of ~node emits that node's split once its left side is done
+    std::vector<int32_t> stack(1, 0);
+    while (!stack.empty()) {
+        int32_t entry = stack.back();
+        stack.pop_back();
+        if (entry < 0) {
+            indices.push_back(nodes[~entry].split);
+            continue;
+        }
+
+        const Node& node = nodes[entry];
+        // the node is drawn while error / distance > threshold, i.e. closer than error / threshold
+        float distance = std::max(boxDistance(viewPos, node.boundsMin, node.boundsMax), 1e-4f);
+        float switchDistance = node.error / threshold;
+        slack = std::min(slack, std::abs(switchDistance - distance));
+        if (distance >= switchDistance) continue;
+
+        if (node.right >= 0) stack.push_back(node.right);
+        stack.push_back(~entry);
+        if (node.left >= 0) stack.push_back(node.left);
+    }
+}
+
+bool PolylineLod::select(const glm::vec3& viewPos, float pixelScale, float maxPixelError)
+{
+    float threshold = maxPixelError / pixelScale;
+    if (walked && threshold == walkThreshold && glm::length(viewPos - walkViewPos) < walkSlack) {
+        lodStats.reuses++;
+        return false;
+    }
+
+    std::vector<uint32_t> indices;
+    if (!points.empty()) indices.push_back(0);
+    float slack = FLT_MAX;
+    if (!nodes.empty()) walk(viewPos, threshold, indices, slack);
+    if (points.size() > 1) indices.push_back((uint32_t)points.size() - 1);
+
+    walked = true;
+    walkViewPos = viewPos;
+    walkThreshold = threshold;
+    walkSlack = slack;
+    lodStats.walks++;
+
+    bool changed = indices.size() != selected.size();
+    for (size_t i = 0; !changed && i < indices.size(); i++)
+        changed = points[indices[i]] != selected[i];
+    if (!changed) return false;
+
+    selected.clear();
+    selected.reserve(indices.size());
+    for (uint32_t index : indices)
+        selected.push_back(points[index]);
+    lodStats.selected = selected.size();
+    selectionRevision++;
+    return true;
+}
@@ -0,0 +1,89 @@
+#include "../Header/PolylineRenderer.h"
+#include "../Header/ResourceRegistry.h"
+#include "../Header/shader.hpp"
+
+#include <algorithm>
+#include <GL/glew.h>
+
+void PolylineRenderer::init()
+{
+    shaderAsset = acquireShader("Shaders/polyline.vert", "Shaders/polyline.frag");
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    // start and end of the segment: the same points, one apart, advancing once per instance
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glVertexAttribDivisor(0, 1);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)sizeof(glm::vec3));
+    glVertexAttribDivisor(1, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    trackResource(ResourceKind::VertexArray, vao, 0, "Scene");
+    trackResource(ResourceKind::Buffer, vbo, 0, "Scene");
+}
+
+void PolylineRenderer::release()
+{
+    if (!vao) return;
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    untrackResource(ResourceKind::VertexArray, vao);
+    untrackResource(ResourceKind::Buffer, vbo);
+    vao = vbo = 0;
+    capacity = pointCount = 0;
+    revision = UINT64_MAX;
+    shaderAsset.reset();
+}
+
+void PolylineRenderer::setPoints(const std::vector<glm::vec3>& points, uint64_t newRevision)
+{
+    if (!vao || newRevision == revision) return;
+    revision = newRevision;
+    pointCount = points.size();
+    polylineStats.segments = pointCount > 1 ? pointCount - 1 : 0;
+    if (pointCount == 0) return;
+
+    size_t bytes = pointCount * sizeof(glm::vec3);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (pointCount > capacity) {
+        // grows by half again, so a route built one click at a time reallocates rarely
+        capacity = std::max(pointCount, capacity + capacity / 2);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::vec3), nullptr, GL_DYNAMIC_DRAW);
+        trackResource(ResourceKind::Buffer, vbo, capacity * sizeof(glm::vec3), "Scene");
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, points.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    polylineStats.uploads++;
+    polylineStats.uploadedBytes += bytes;
+}
+
+void PolylineRenderer::draw(const glm::mat4& viewProjection, const glm::vec4& viewport, float widthPixels, const glm::vec4& color)
+{
+    if (!vao || pointCount < 2) return;
+
+    Shader& shader = *shaderAsset.get<Shader>();
+    shader.use();
+    shader.setMat4(shader.viewProjectionLocation, viewProjection);
+    shader.setVec4("uViewport", viewport);
+    shader.setFloat("uHalfWidth", widthPixels * 0.5f);
+    shader.setVec4("uColor", color);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // joins overlap; a written depth would cut the second segment's cap out of the first
+    glDepthMask(GL_FALSE);
+    GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+    glDisable(GL_CULL_FACE);
+
+    glBindVertexArray(vao);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)(pointCount - 1));
+    glBindVertexArray(0);
+
+    if (cullFace) glEnable(GL_CULL_FACE);
+    glDepthMask(GL_TRUE);
+}
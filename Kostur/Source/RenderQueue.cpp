@@ -0,0 +1,231 @@
+#include "../Header/RenderQueue.h"
+
+#include <algorithm>
+#include <cmath>
+
+void RenderQueue::begin(const glm::vec3& viewPos, float farPlane)
+{
+    this->viewPos = viewPos;
+    this->farPlane = farPlane;
+    packets.clear();
+    // only this frame's programs and VAOs: hot reloads and new variants would otherwise
+    // pile up slots until the key's 8 program bits alias unrelated programs
+    programSlots.clear();
+    vaoSlots.clear();
+}
+
+void RenderQueue::setPassSetup(RenderPass pass, PassSetup setup)
+{
+    passSetups[(int)pass] = setup;
+}
+
+void RenderQueue::setPassFeatures(RenderPass pass, unsigned int features)
+{
+    passFeatures[(int)pass] = features;
+}
+
+unsigned int RenderQueue::slotFor(std::vector<unsigned int>& slots, unsigned int id)
+{
+    // GL names are small but not dense; slots keep them compact enough for the key
+    auto it = std::find(slots.begin(), slots.end(), id);
+    if (it != slots.end()) return (unsigned int)(it - slots.begin());
+    slots.push_back(id);
+    return (unsigned int)slots.size() - 1;
+}
+
+void RenderQueue::submit(RenderPass pass, Shader& shader, unsigned int vao, GLenum mode, GLint first, GLint baseVertex, GLsizei count, bool indexed,
+                         GLenum indexType, const glm::mat4& model, const Material& material, float lineWidth)
+{
+    DrawPacket packet;
+    packet.shader = &shader;
+    packet.vao = vao;
+    packet.material = &material;
+    packet.mode = mode;
+    packet.first = first;
+    packet.baseVertex = baseVertex;
+    packet.count = count;
+    packet.indexType = indexType;
+    packet.indexed = indexed;
+    packet.lineWidth = lineWidth;
+    packet.model = model;
+
+    // Opaque draws go front to back to make the most of early depth rejection.
+    float distance = glm::distance(viewPos, glm::vec3(model[3]));
+    uint64_t depth = (uint64_t)(glm::clamp(distance / farPlane, 0.0f, 1.0f) * 0xFFFFFF);
+
+    packet.key = ((uint64_t)pass & 0xF) << 60
+               | ((uint64_t)slotFor(programSlots, shader.ID) & 0xFF) << 52
+               | ((uint64_t)material.id & 0xFFF) << 40
+               | ((uint64_t)slotFor(vaoSlots, vao) & 0xFFFF) << 24
+               | depth;
+    packets.push_back(packet);
+}
+
+void RenderQueue::submitArrays(RenderPass pass, Shader& shader, unsigned int vao, GLenum mode, GLint first, GLsizei count,
+                               const glm::mat4& model, const Material& material, float lineWidth)
+{
+    submit(pass, shader, vao, mode, first, 0, count, false, GL_UNSIGNED_INT, model, material, lineWidth);
+}
+
+void RenderQueue::submitElements(RenderPass pass, Shader& shader, unsigned int vao, GLsizei indexCount,
+                                 const glm::mat4& model, const Material& material, GLint firstIndex, GLint baseVertex,
+                                 GLenum indexType)
+{
+    submit(pass, shader, vao, GL_TRIANGLES, firstIndex, baseVertex, indexCount, true, indexType, model, material, 1.0f);
+}
+
+void RenderQueue::submitArrays(RenderPass pass, ShaderVariants& shaders, unsigned int vao, GLenum mode, GLint first, GLsizei count,
+                               const glm::mat4& model, const Material& material, float lineWidth)
+{
+    Shader& shader = shaders.select(passFeatures[(int)pass] | material.ShaderFeatures());
+    submit(pass, shader, vao, mode, first, 0, count, false, GL_UNSIGNED_INT, model, material, lineWidth);
+}
+
+void RenderQueue::submitElements(RenderPass pass, ShaderVariants& shaders, unsigned int vao, GLsizei indexCount,
+                                 const glm::mat4& model, const Material& material, GLint firstIndex, GLint baseVertex,
+                                 GLenum indexType)
+{
+    Shader& shader = shaders.select(passFeatures[(int)pass] | material.ShaderFeatures());
+    submit(pass, shader, vao, GL_TRIANGLES, firstIndex, baseVertex, indexCount, true, indexType, model, material, 1.0f);
+}
+
+bool RenderQueue::canMerge(const DrawPacket& a, const DrawPacket& b)
+{
+    return a.indexed && b.indexed
+        && (a.key >> 60) == (b.key >> 60)
+        && a.shader->ID == b.shader->ID
+        && a.material == b.material
+        && a.vao == b.vao
+        && a.mode == b.mode
+        && a.indexType == b.indexType
+        && a.model == b.model;
+}
+
+void RenderQueue::computeNormalMatrices(RenderQueueStats& stats)
+{
+    // inverse-transpose of the upper 3x3, written with cross products: (M^-1)^T = [m1 x m2, m2 x m0, m0 x m1] / det.
+    // with uniform scale s the columns are orthogonal and equally long, and that reduces to M / s^2
+    normalMatrices.resize(packets.size());
+    for (size_t i = 0; i < packets.size(); i++) {
+        const glm::mat4& m = packets[i].model;
+        glm::vec3 c0(m[0]), c1(m[1]), c2(m[2]);
+        float s0 = glm::dot(c0, c0), s1 = glm::dot(c1, c1), s2 = glm::dot(c2, c2);
+        float tolerance = 1e-4f * s0;
+
+        bool uniformScale = s0 > 0.0f
+            && std::fabs(s0 - s1) <= tolerance && std::fabs(s0 - s2) <= tolerance
+            && std::fabs(glm::dot(c0, c1)) <= tolerance && std::fabs(glm::dot(c0, c2)) <= tolerance && std::fabs(glm::dot(c1, c2)) <= tolerance;
+
+        if (uniformScale) {
+            float inverseScale2 = 1.0f / s0;
+            normalMatrices[i] = glm::mat3(c0 * inverseScale2, c1 * inverseScale2, c2 * inverseScale2);
+            stats.uniformScaleNormals++;
+        }
+        else {
+            glm::vec3 r0 = glm::cross(c1, c2), r1 = glm::cross(c2, c0), r2 = glm::cross(c0, c1);
+            float det = glm::dot(c0, r0);
+            float inverseDet = det != 0.0f ? 1.0f / det : 0.0f;
+            normalMatrices[i] = glm::mat3(r0 * inverseDet, r1 * inverseDet, r2 * inverseDet);
+            stats.generalNormals++;
+        }
+    }
+}
+
+void RenderQueue::flush()
+{
+    std::stable_sort(packets.begin(), packets.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.key < b.key; });
+
+    RenderQueueStats stats;
+    stats.packets = (unsigned int)packets.size();
+    computeNormalMatrices(stats);
+
+    int currentPass = -1;
+    unsigned int currentProgram = 0;
+    unsigned int currentVAO = 0;
+    const Material* currentMaterial = nullptr;
+    MaterialBindState materialState;
+    float currentLineWidth = 1.0f;
+
+    for (size_t i = 0; i < packets.size(); i++) {
+        const DrawPacket& packet = packets[i];
+        int pass = (int)(packet.key >> 60);
+        if (pass != currentPass) {
+            // A new pass may change per-pass uniforms, so program state has to be re-established
+            currentPass = pass;
+            currentProgram = 0;
+        }
+
+        if (packet.shader->ID != currentProgram) {
+            packet.shader->use();
+            currentProgram = packet.shader->ID;
+            stats.programBinds++;
+            if (passSetups[pass]) passSetups[pass](*packet.shader);
+        }
+        else stats.programBindsSaved++;
+
+        // Material constants live in a UBO at a fixed binding point, so they survive program switches
+        if (packet.material != currentMaterial) {
+            packet.material->Bind(&materialState);
+            currentMaterial = packet.material;
+            stats.materialBinds++;
+        }
+        else stats.materialBindsSaved++;
+
+        if (packet.vao != currentVAO) {
+            glBindVertexArray(packet.vao);
+            currentVAO = packet.vao;
+            stats.vaoBinds++;
+        }
+        else stats.vaoBindsSaved++;
+
+        if (packet.lineWidth != currentLineWidth) {
+            glLineWidth(packet.lineWidth);
+            currentLineWidth = packet.lineWidth;
+        }
+
+        packet.shader->setMat4(packet.shader->modelLocation, packet.model);
+        packet.shader->setMat3(packet.shader->normalLocation, normalMatrices[i]);
+        stats.drawCalls++;
+        if (packet.mode == GL_TRIANGLES) stats.triangles += packet.count / 3;
+
+        if (!packet.indexed) {
+            glDrawArrays(packet.mode, packet.first, packet.count);
+            continue;
+        }
+
+        // gather the run of packets that only differ in their index range
+        size_t runEnd = i + 1;
+        while (runEnd < packets.size() && canMerge(packet, packets[runEnd])) runEnd++;
+
+        if (runEnd - i == 1) {
+            glDrawElementsBaseVertex(packet.mode, packet.count, packet.indexType,
+                                     (const void*)(packet.first * indexSize(packet.indexType)), packet.baseVertex);
+            continue;
+        }
+
+        multiCounts.clear();
+        multiOffsets.clear();
+        multiBaseVertices.clear();
+        for (size_t j = i; j < runEnd; j++) {
+            multiCounts.push_back(packets[j].count);
+            multiOffsets.push_back((const void*)(packets[j].first * indexSize(packets[j].indexType)));
+            multiBaseVertices.push_back(packets[j].baseVertex);
+            if (j > i && packets[j].mode == GL_TRIANGLES) stats.triangles += packets[j].count / 3;
+        }
+        glMultiDrawElementsBaseVertex(packet.mode, multiCounts.data(), packet.indexType, multiOffsets.data(),
+                                      (GLsizei)multiCounts.size(), multiBaseVertices.data());
+        stats.mergedDraws += (unsigned int)(runEnd - i - 1);
+        stats.materialBindsSaved += (unsigned int)(runEnd - i - 1);
+        stats.vaoBindsSaved += (unsigned int)(runEnd - i - 1);
+        stats.programBindsSaved += (unsigned int)(runEnd - i - 1);
+        i = runEnd - 1;
+    }
+
+    if (currentLineWidth != 1.0f) glLineWidth(1.0f);
+    glBindVertexArray(0);
+
+    stats.textureBinds = materialState.textureBinds;
+    stats.textureBindsSaved = materialState.textureBindsSaved;
+    lastStats = stats;
+    packets.clear();
+}
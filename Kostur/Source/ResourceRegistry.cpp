@@ -0,0 +1,193 @@
+#include "../Header/ResourceRegistry.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+static std::vector<ResourceInfo> resources;
+static size_t totalBytes = 0;
+static size_t budgetBytes = 0;
+static bool overBudget = false;
+
+static std::string formatBytes(size_t bytes)
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2);
+    if (bytes >= 1024 * 1024)
+        ss << bytes / (1024.0 * 1024.0) << " MB";
+    else
+        ss << bytes / 1024.0 << " KB";
+    return ss.str();
+}
+
+static void checkBudget()
+{
+    if (budgetBytes == 0) return;
+
+    if (totalBytes > budgetBytes && !overBudget) {
+        std::cout << "WARNING::RESOURCES:: memory budget exceeded: " << formatBytes(totalBytes)
+                  << " tracked, budget is " << formatBytes(budgetBytes) << std::endl;
+        overBudget = true;
+    }
+    else if (totalBytes <= budgetBytes) {
+        overBudget = false;
+    }
+}
+
+static std::vector<ResourceInfo>::iterator findResource(ResourceKind kind, unsigned int id)
+{
+    return std::find_if(resources.begin(), resources.end(), [&](const ResourceInfo& r) {
+        return r.kind == kind && r.id == id;
+    });
+}
+
+void trackResource(ResourceKind kind, unsigned int id, size_t bytes, const std::string& owner, const std::string& origin)
+{
+    // Re-tracking an existing object (e.g. a dynamic buffer that was re-uploaded) just updates its size.
+    auto it = findResource(kind, id);
+    if (it != resources.end()) {
+        totalBytes -= it->bytes;
+        it->bytes = bytes;
+        it->owner = owner;
+        if (!origin.empty()) it->origin = origin;
+    }
+    else {
+        resources.push_back({ kind, id, bytes, owner, origin });
+    }
+    totalBytes += bytes;
+    checkBudget();
+}
+
+void untrackResource(ResourceKind kind, unsigned int id)
+{
+    auto it = findResource(kind, id);
+    if (it == resources.end()) return;
+
+    totalBytes -= it->bytes;
+    resources.erase(it);
+    checkBudget();
+}
+
+size_t estimateTextureBytes(int width, int height, int channels, bool mipmapped)
+{
+    size_t base = (size_t)width * (size_t)height * (size_t)channels;
+    // A full mip chain adds roughly a third on top of the base level.
+    return mipmapped ? base + base / 3 : base;
+}
+
+size_t trackedBytes()
+{
+    return totalBytes;
+}
+
+size_t trackedBytes(ResourceKind kind)
+{
+    size_t sum = 0;
+    for (const ResourceInfo& r : resources)
+        if (r.kind == kind) sum += r.bytes;
+    return sum;
+}
+
+size_t trackedCount(ResourceKind kind)
+{
+    return std::count_if(resources.begin(), resources.end(), [&](const ResourceInfo& r) { return r.kind == kind; });
+}
+
+const std::vector<ResourceInfo>& trackedResources()
+{
+    return resources;
+}
+
+void setMemoryBudget(size_t bytes)
+{
+    budgetBytes = bytes;
+    overBudget = false;
+    checkBudget();
+}
+
+size_t memoryBudget()
+{
+    return budgetBytes;
+}
+
+const char* resourceKindName(ResourceKind kind)
+{
+    switch (kind) {
+    case ResourceKind::Texture:     return "texture";
+    case ResourceKind::Buffer:      return "buffer";
+    case ResourceKind::VertexArray: return "vertex_array";
+    case ResourceKind::CpuData:     return "cpu";
+    }
+    return "unknown";
+}
+
+static std::string jsonEscape(const std::string& s)
+{
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if ((unsigned char)c < 0x20) out += ' ';
+        else out += c;
+    }
+    return out;
+}
+
+bool dumpResourcesJson(const char* path)
+{
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cout << "ERROR::RESOURCES:: unable to write " << path << std::endl;
+        return false;
+    }
+
+    file << "{\n";
+    file << "  \"totalBytes\": " << totalBytes << ",\n";
+    file << "  \"budgetBytes\": " << budgetBytes << ",\n";
+    file << "  \"resources\": [\n";
+    for (size_t i = 0; i < resources.size(); i++) {
+        const ResourceInfo& r = resources[i];
+        file << "    { \"kind\": \"" << resourceKindName(r.kind) << "\", \"id\": " << r.id
+             << ", \"bytes\": " << r.bytes
+             << ", \"owner\": \"" << jsonEscape(r.owner) << "\""
+             << ", \"origin\": \"" << jsonEscape(r.origin) << "\" }"
+             << (i + 1 < resources.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n";
+    file << "}\n";
+
+    std::cout << "Resource registry written to " << path << std::endl;
+    return true;
+}
+
+std::vector<std::string> resourceSummaryLines(size_t maxEntries)
+{
+    std::vector<std::string> lines;
+
+    std::stringstream header;
+    header << "Memory: " << formatBytes(totalBytes);
+    if (budgetBytes > 0) header << " / " << formatBytes(budgetBytes) << (overBudget ? "  OVER BUDGET" : "");
+    lines.push_back(header.str());
+
+    const ResourceKind kinds[] = { ResourceKind::Texture, ResourceKind::Buffer, ResourceKind::VertexArray, ResourceKind::CpuData };
+    for (ResourceKind kind : kinds) {
+        std::stringstream ss;
+        ss << resourceKindName(kind) << ": " << trackedCount(kind) << " objects, " << formatBytes(trackedBytes(kind));
+        lines.push_back(ss.str());
+    }
+
+    // Largest individual allocations first
+    std::vector<const ResourceInfo*> sorted;
+    for (const ResourceInfo& r : resources) sorted.push_back(&r);
+    std::sort(sorted.begin(), sorted.end(), [](const ResourceInfo* a, const ResourceInfo* b) { return a->bytes > b->bytes; });
+
+    for (size_t i = 0; i < sorted.size() && i < maxEntries; i++) {
+        std::stringstream ss;
+        ss << formatBytes(sorted[i]->bytes) << "  " << resourceKindName(sorted[i]->kind) << " #" << sorted[i]->id
+           << "  " << sorted[i]->owner;
+        if (!sorted[i]->origin.empty()) ss << "  " << sorted[i]->origin;
+        lines.push_back(ss.str());
+    }
+    return lines;
+}
@@ -0,0 +1,49 @@
+#include "../Header/ShaderVariants.h"
+
+#include <iostream>
+
+ShaderVariants::ShaderVariants(const std::string& vertexPath, const std::string& fragmentPath, const std::vector<std::string>& featureNames)
+    : vertexPath(vertexPath), fragmentPath(fragmentPath), featureNames(featureNames)
+{
+}
+
+std::vector<std::string> ShaderVariants::definesFor(unsigned int features) const
+{
+    std::vector<std::string> defines;
+    for (size_t i = 0; i < featureNames.size(); i++)
+        if (features & (1u << i)) defines.push_back(featureNames[i]);
+    return defines;
+}
+
+Shader& ShaderVariants::select(unsigned int features)
+{
+    if (lastShader && features == lastFeatures) return *lastShader;
+
+    std::unordered_map<unsigned int, AssetHandle>::iterator it = variants.find(features);
+    if (it == variants.end()) {
+        if (features >> featureNames.size())
+            std::cout << "ERROR::SHADER_VARIANTS:: unknown feature bits " << (features >> featureNames.size()) << " for " << fragmentPath << std::endl;
+
+        AssetHandle handle = acquireShader(vertexPath, fragmentPath, definesFor(features));
+        Shader& shader = *handle.get<Shader>();
+        shader.programSetup = programSetup;
+        if (programSetup) programSetup(shader);
+        it = variants.emplace(features, handle).first;
+    }
+
+    lastFeatures = features;
+    lastShader = it->second.get<Shader>();
+    return *lastShader;
+}
+
+void ShaderVariants::prewarm(const std::vector<unsigned int>& keys)
+{
+    for (unsigned int features : keys)
+        select(features);
+}
+
+void ShaderVariants::clear()
+{
+    variants.clear();
+    lastShader = nullptr;
+}
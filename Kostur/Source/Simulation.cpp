@@ -0,0 +1,328 @@
+#include "../Header/Simulation.h"
+#include "../Header/MeshBvh.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+// longest real time a single step() will simulate; anything beyond (debugger, suspended process) is dropped
+const float MAX_STEP_TIME = 0.25f;
+
+Simulation::Simulation()
+    : running(false)
+{
+    config = SimConfig();
+    published = std::make_shared<const SimState>(state);
+}
+
+Simulation::~Simulation()
+{
+    stop();
+}
+
+void Simulation::init(const SimConfig& config, const SimState& initial)
+{
+    this->config = config;
+    state = initial;
+    state.previousCameraPos = state.cameraPos;
+    state.previousPlayerPos = state.playerPos;
+    heldKeys = 0;
+    accumulator = 0.0f;
+    publish();
+}
+
+void Simulation::start()
+{
+    if (running.load()) return;
+    running.store(true);
+    thread = std::thread(&Simulation::run, this);
+}
+
+void Simulation::stop()
+{
+    running.store(false);
+    if (thread.joinable()) thread.join();
+}
+
+bool Simulation::pushEvent(const SimEvent& event)
+{
+    return events.push(event);
+}
+
+void Simulation::setPickShapes(std::shared_ptr<const ModelBvh> player, std::shared_ptr<const ModelBvh> pin)
+{
+    std::atomic_store(&playerShape, player);
+    std::atomic_store(&pinShape, pin);
+}
+
+std::shared_ptr<const SimState> Simulation::snapshot() const
+{
+    return std::atomic_load(&published);
+}
+
+float Simulation::interpolation(const SimState& snapshot) const
+{
+    float alpha = snapshot.interpolation;
+    if (running.load())
+        alpha += (float)((clock() - snapshot.publishTime) * config.tickRate);
+    return std::min(alpha, 1.0f);
+}
+
+double Simulation::clock()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Simulation::run()
+{
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / config.tickRate));
+
+    Clock::time_point last = Clock::now();
+    Clock::time_point next = last + period;
+    while (running.load()) {
+        Clock::time_point now = Clock::now();
+        step(std::chrono::duration<float>(now - last).count());
+        last = now;
+
+        std::this_thread::sleep_until(next);
+        next += period;
+        // fell far behind (debugger, suspended process): don't try to catch up tick by tick
+        if (Clock::now() > next + period) next = Clock::now() + period;
+    }
+}
+
+void Simulation::step(float dt)
+{
+    SimEvent event;
+    while (events.pop(event))
+        apply(event);
+
+    const float tickTime = 1.0f / config.tickRate;
+    accumulator += std::min(dt, MAX_STEP_TIME);
+    while (accumulator >= tickTime) {
+        tick(tickTime);
+        accumulator -= tickTime;
+    }
+    publish();
+}
+
+void Simulation::publish()
+{
+    state.interpolation = accumulator * config.tickRate;
+    state.publishTime = clock();
+    std::atomic_store(&published, std::shared_ptr<const SimState>(std::make_shared<const SimState>(state)));
+}
+
+void Simulation::apply(const SimEvent& event)
+{
+    switch (event.type) {
+    case SimEventType::HeldKeys:
+        heldKeys = event.heldKeys;
+        break;
+    case SimEventType::ToggleMode:
+        toggleMode();
+        break;
+    case SimEventType::Click:
+        click(event.x, event.y);
+        break;
+    }
+    if (event.sequence > state.appliedSequence) state.appliedSequence = event.sequence;
+}
+
+void Simulation::toggleMode()
+{
+    if (state.isWalkingMode) {
+        state.savedWalkPos = state.cameraPos;
+        state.isWalkingMode = false;
+        state.cameraPos = state.savedMeasurePos;
+    }
+    else {
+        // Switch to Walking
+        state.savedMeasurePos = state.cameraPos;
+        state.isWalkingMode = true;
+        state.cameraPos = state.savedWalkPos;
+    }
+    // the camera jumps; don't sweep it across the map while interpolating
+    state.previousCameraPos = state.cameraPos;
+}
+
+void Simulation::tick(float dt)
+{
+    float velocity = config.playerSpeed * dt;
+    float camSpeed = config.cameraSpeed * dt;
+    glm::vec3& playerPos = state.playerPos;
+    glm::vec3& cameraPos = state.cameraPos;
+    state.previousPlayerPos = playerPos;
+    state.previousCameraPos = cameraPos;
+    state.tick++;
+
+    if (state.isWalkingMode) {
+        // Player Movement
+        glm::vec3 oldPos = playerPos;
+        if (heldKeys & SimKeyWalkForward) { playerPos.z -= velocity; state.playerRotation = 180.0f; }
+        if (heldKeys & SimKeyWalkBack)    { playerPos.z += velocity; state.playerRotation = 0.0f; }
+        if (heldKeys & SimKeyWalkLeft)    { playerPos.x -= velocity; state.playerRotation = -90.0f; }
+        if (heldKeys & SimKeyWalkRight)   { playerPos.x += velocity; state.playerRotation = 90.0f; }
+
+        // Bounds check
+        if (playerPos.x < -config.mapSize || playerPos.x > config.mapSize || playerPos.z < -config.mapSize || playerPos.z > config.mapSize)
+            playerPos = oldPos;
+        state.totalWalkDistance += glm::distance(playerPos, oldPos);
+    }
+
+    // Camera Movement
+    if (heldKeys & SimKeyCameraUp)    cameraPos.z -= camSpeed;
+    if (heldKeys & SimKeyCameraDown)  cameraPos.z += camSpeed;
+    if (heldKeys & SimKeyCameraLeft)  cameraPos.x -= camSpeed;
+    if (heldKeys & SimKeyCameraRight) cameraPos.x += camSpeed;
+
+    // Camera Limits
+    if (cameraPos.x > config.mapSize) cameraPos.x = config.mapSize;
+    if (cameraPos.x < -config.mapSize) cameraPos.x = -config.mapSize;
+
+    if (state.isWalkingMode) {
+        if (cameraPos.z > 12.0f) cameraPos.z = 12.0f;
+        if (cameraPos.z < -8.0f) cameraPos.z = -8.0f;
+    }
+    else {
+        if (cameraPos.z > 20.0f) cameraPos.z = 20.0f;
+        if (cameraPos.z < 0.0f) cameraPos.z = 0.0f;
+    }
+}
+
+void Simulation::click(double x, double y)
+{
+    // A. CHECK ICON CLICK
+    float iconLeft = config.screenWidth - (config.iconSize + config.iconPadding);
+    float iconRight = config.screenWidth - config.iconPadding;
+    float iconTop = config.iconPadding;
+    float iconBottom = config.iconPadding + config.iconSize;
+
+    if (x >= iconLeft && x <= iconRight && y >= iconTop && y <= iconBottom) {
+        toggleMode();
+        return;
+    }
+
+    // B. PICK: pins in measuring mode, the player while walking, else the ground
+    glm::vec3 origin, direction;
+    clickRay(x, y, origin, direction);
+    double pickStart = clock();
+    SimPick hit;
+    pick(origin, direction, hit);
+    hit.microseconds = (clock() - pickStart) * 1e6;
+    state.lastPick = hit;
+
+    // C. CHECK MAP CLICK (Only in Measuring Mode)
+    if (state.isWalkingMode) return;
+
+    std::vector<glm::vec3>& points = state.measurementPoints;
+    if (hit.entity == SimEntity::Pin) {
+        // clicking a pin (its head included, which hangs over ground further back) removes its point
+        points.erase(points.begin() + hit.index);
+    }
+    else {
+        if (hit.entity != SimEntity::Ground) return;
+        glm::vec3 hitPoint = hit.point;
+        if (hitPoint.x < -config.mapSize || hitPoint.x > config.mapSize || hitPoint.z < -config.mapSize || hitPoint.z > config.mapSize) return;
+
+        // Delete if close to existing, else Add
+        bool deleted = false;
+        for (size_t i = 0; i < points.size(); i++) {
+            if (glm::distance(points[i], hitPoint) < 0.5f) {
+                points.erase(points.begin() + i);
+                deleted = true;
+                break;
+            }
+        }
+        if (!deleted) points.push_back(hitPoint);
+    }
+
+    // Recalculate total length
+    state.measurementRevision++;
+    state.totalMeasuredLength = 0.0f;
+    for (size_t i = 1; i < points.size(); i++)
+        state.totalMeasuredLength += glm::distance(points[i - 1], points[i]);
+}
+
+// Ray from the camera through the mouse position, in world space
+void Simulation::clickRay(double x, double y, glm::vec3& origin, glm::vec3& direction) const
+{
+    float width = (float)config.screenWidth, height = (float)config.screenHeight;
+    glm::mat4 projection = glm::perspective(config.fovy, width / height, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(state.cameraPos, state.cameraPos + config.cameraFront, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::vec4 viewport = glm::vec4(0.0f, 0.0f, width, height);
+
+    origin = glm::unProject(glm::vec3((float)x, height - (float)y, 0.0f), view, projection, viewport);
+    glm::vec3 rayEnd = glm::unProject(glm::vec3((float)x, height - (float)y, 1.0f), view, projection, viewport);
+    direction = glm::normalize(rayEnd - origin);
+}
+
+// Raycast onto the map plane (y=0)
+bool Simulation::groundIntersection(const glm::vec3& origin, const glm::vec3& direction, glm::vec3& hit) const
+{
+    // t = -start.y / dir.y
+    if (direction.y == 0.0f) return false;
+    float t = -origin.y / direction.y;
+    if (t < 0.0f) return false; // Intersection is behind camera
+
+    hit = origin + direction * t;
+    return true;
+}
+
+// Closest model hit along the ray. Every instance is tested in its own object space (the direction
+// keeps the model matrix's scale, so t stays a world-space distance); the model's bounds reject
+// most instances before any BVH node is touched
+bool Simulation::pick(const glm::vec3& origin, const glm::vec3& direction, SimPick& result) const
+{
+    std::shared_ptr<const ModelBvh> player = std::atomic_load(&playerShape);
+    std::shared_ptr<const ModelBvh> pin = std::atomic_load(&pinShape);
+
+    RayHit hit;
+    auto test = [&](const ModelBvh& shape, const glm::mat4& model, SimEntity entity, unsigned int index) {
+        glm::mat4 inverse = glm::inverse(model);
+        glm::vec3 localOrigin = glm::vec3(inverse * glm::vec4(origin, 1.0f));
+        glm::vec3 localDirection = glm::vec3(inverse * glm::vec4(direction, 0.0f));
+        if (!shape.intersect(localOrigin, localDirection, hit)) return;
+        result.entity = entity;
+        result.index = index;
+    };
+
+    if (state.isWalkingMode && player)
+        test(*player, playerModelMatrix(state.playerPos, state.playerRotation), SimEntity::Player, 0);
+    if (!state.isWalkingMode && pin)
+        for (unsigned int i = 0; i < state.measurementPoints.size(); i++)
+            test(*pin, pinModelMatrix(state.measurementPoints[i]), SimEntity::Pin, i);
+
+    if (result.entity != SimEntity::None) {
+        result.mesh = hit.mesh;
+        result.triangle = hit.triangle;
+        result.barycentric = hit.barycentric;
+        result.point = origin + direction * hit.t;
+        return true;
+    }
+    if (groundIntersection(origin, direction, result.point)) {
+        result.entity = SimEntity::Ground;
+        return true;
+    }
+    return false;
+}
+
+glm::mat4 playerModelMatrix(const glm::vec3& position, float rotationDegrees)
+{
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, position);
+    model = glm::rotate(model, glm::radians(rotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
+    model = glm::scale(model, glm::vec3(0.01f));
+    return model;
+}
+
+glm::mat4 pinModelMatrix(const glm::vec3& point)
+{
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, point);
+    model = glm::translate(model, glm::vec3(0.0f, 0.75f, 0.0f));
+    model = glm::scale(model, glm::vec3(0.2f));
+    return model;
+}
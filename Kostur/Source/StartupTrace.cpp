@@ -0,0 +1,160 @@
+#include "../Header/StartupTrace.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+struct StartupPhase {
+    std::string name;
+    double startMs;
+    double endMs;
+};
+
+struct AssetTiming {
+    std::string asset;
+    std::string phase;
+    double ms;
+};
+
+struct StartupMilestone {
+    std::string name;
+    double ms;
+};
+
+static const std::chrono::steady_clock::time_point traceStart = std::chrono::steady_clock::now();
+static std::vector<StartupPhase> phases;
+static std::vector<AssetTiming> assets;
+static std::vector<StartupMilestone> milestones;
+static bool phaseOpen = false;
+static bool tracing = true;
+
+double startupNowMs()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - traceStart).count();
+}
+
+bool isStartupTracing()
+{
+    return tracing;
+}
+
+void beginStartupPhase(const std::string& name)
+{
+    if (!tracing) return;
+    endStartupPhase();
+    phases.push_back({ name, startupNowMs(), 0.0 });
+    phaseOpen = true;
+}
+
+void endStartupPhase()
+{
+    if (!phaseOpen) return;
+    phases.back().endMs = startupNowMs();
+    phaseOpen = false;
+}
+
+void recordAssetTiming(const std::string& asset, double ms)
+{
+    if (!tracing) return;
+    assets.push_back({ asset, phaseOpen ? phases.back().name : "", ms });
+}
+
+void markStartupMilestone(const std::string& name)
+{
+    if (!tracing) return;
+    milestones.push_back({ name, startupNowMs() });
+}
+
+// empty when the milestone was never reached, so the CSV column stays in place
+static std::string milestoneField(const std::string& name)
+{
+    for (const StartupMilestone& milestone : milestones) {
+        if (milestone.name != name) continue;
+        std::ostringstream field;
+        field << std::fixed << std::setprecision(3) << milestone.ms;
+        return field.str();
+    }
+    return "";
+}
+
+// the whole string as a number; false for empty or malformed fields
+static bool parseMs(const std::string& text, double& ms)
+{
+    char* end;
+    ms = std::strtod(text.c_str(), &end);
+    return !text.empty() && *end == '\0';
+}
+
+void printStartupReport()
+{
+    endStartupPhase();
+    tracing = false;
+
+    double total = startupNowMs();
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "--- Startup trace (" << total << " ms) ---" << std::endl;
+    for (const StartupPhase& phase : phases) {
+        double ms = phase.endMs - phase.startMs;
+        std::cout << "  " << std::left << std::setw(14) << phase.name << std::right << std::setw(10) << ms << " ms"
+                  << std::setw(8) << (total > 0.0 ? 100.0 * ms / total : 0.0) << " %" << std::endl;
+
+        for (const AssetTiming& asset : assets) {
+            if (asset.phase == phase.name)
+                std::cout << "      " << std::setw(10) << asset.ms << " ms  " << asset.asset << std::endl;
+        }
+    }
+    for (const StartupMilestone& milestone : milestones)
+        std::cout << "  @ " << std::left << std::setw(12) << milestone.name << std::right << std::setw(10) << milestone.ms << " ms" << std::endl;
+    std::cout << std::defaultfloat;
+}
+
+bool appendStartupBenchmark(const char* path, const std::string& label)
+{
+    {
+        std::ofstream file(path, std::ios::app);
+        if (!file.is_open()) {
+            std::cout << "ERROR::STARTUP:: unable to write " << path << std::endl;
+            return false;
+        }
+        file << std::fixed << std::setprecision(3) << label << "," << milestoneField("first_frame") << "," << milestoneField("models_ready") << ",";
+        for (size_t i = 0; i < phases.size(); i++)
+            file << (i ? ";" : "") << phases[i].name << "=" << (phases[i].endMs - phases[i].startMs);
+        file << "\n";
+    }
+
+    // Summarize every run recorded so far, grouped by label
+    std::ifstream in(path);
+    std::map<std::string, std::pair<double, int>> firstFrame, modelsReady;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        std::string runLabel, runFirstFrame, runModelsReady;
+        if (!std::getline(ss, runLabel, ',') || !std::getline(ss, runFirstFrame, ',')) continue;
+        // a hand-edited or truncated line is skipped rather than ending the run
+        double ms;
+        if (!parseMs(runFirstFrame, ms)) continue;
+        firstFrame[runLabel].first += ms;
+        firstFrame[runLabel].second++;
+        if (std::getline(ss, runModelsReady, ',') && parseMs(runModelsReady, ms)) {
+            modelsReady[runLabel].first += ms;
+            modelsReady[runLabel].second++;
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    for (const auto& entry : firstFrame) {
+        std::cout << "Startup benchmark [" << entry.first << "]: " << entry.second.second << " runs, avg "
+                  << entry.second.first / entry.second.second << " ms to first frame";
+        auto ready = modelsReady.find(entry.first);
+        if (ready != modelsReady.end())
+            std::cout << ", " << ready->second.first / ready->second.second << " ms to models ready (" << ready->second.second << " runs)";
+        std::cout << std::endl;
+    }
+    std::cout << std::defaultfloat;
+    return true;
+}
@@ -1,14 +1,27 @@
 #include <iostream>
 #include <freetype/freetype.h>
 #include "../Header/TextUtil.h";
+#include "../Header/ResourceRegistry.h"
+#include "../Header/StartupTrace.h"
+#include "../Header/AssetPack.h"
 
+#include <algorithm>
 #include <map>
 #include <GL/glew.h>
 
+// glyphs are packed in rows this wide, one texel apart so linear filtering doesn't bleed
+#define TEXT_ATLAS_WIDTH 1024
+#define TEXT_ATLAS_PADDING 1
+
 std::map<char, Character> Characters;
 unsigned int textVAO, textVBO;
+unsigned int atlasTexture = 0;
+std::vector<GlyphQuad> textQuads;
+std::vector<float> textVertices;
+size_t textVBOBytes = 0;
 
 void initText(unsigned int shaderProgram, const char* fontPath) {
+    ScopedAssetTimer timer(fontPath);
     FT_Library ft;
     if (FT_Init_FreeType(&ft))
     {
@@ -16,8 +29,10 @@ void initText(unsigned int shaderProgram, const char* fontPath) {
         return;
     }
 
+    // FreeType reads the font in place; the view has to outlive the face
+    AssetView fontFile;
     FT_Face face;
-    if (FT_New_Face(ft, fontPath, 0, &face))
+    if (!readAsset(fontPath, fontFile) || FT_New_Memory_Face(ft, fontFile.data, (FT_Long)fontFile.size, 0, &face))
     {
         std::cout << "ERROR::FREETYPE: Unable to load the font" << std::endl;
         return;
@@ -25,8 +40,10 @@ void initText(unsigned int shaderProgram, const char* fontPath) {
 
     FT_Set_Pixel_Sizes(face, 0, 48);
 
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
+    // 1. render every glyph and give it a place in the atlas (shelf packing, rows of TEXT_ATLAS_WIDTH)
+    std::vector<std::vector<unsigned char>> bitmaps(128);
+    std::vector<int> atlasX(128, 0), atlasY(128, 0);
+    int penX = 0, penY = 0, rowHeight = 0;
     for (unsigned char c = 0; c < 128; c++)
     {
         if (FT_Load_Char(face, c, FT_LOAD_RENDER))
@@ -34,88 +51,156 @@ void initText(unsigned int shaderProgram, const char* fontPath) {
             std::cout << "ERROR::FREETYPE: Failed to load characters" << std::endl;
             continue;
         }
+        const FT_Bitmap& bitmap = face->glyph->bitmap;
+        int width = (int)bitmap.width, rows = (int)bitmap.rows;
+        for (int row = 0; row < rows; row++)
+            bitmaps[c].insert(bitmaps[c].end(), bitmap.buffer + row * bitmap.pitch, bitmap.buffer + row * bitmap.pitch + width);
 
-        unsigned int texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
-        );
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        if (penX + width > TEXT_ATLAS_WIDTH)
+        {
+            penX = 0;
+            penY += rowHeight + TEXT_ATLAS_PADDING;
+            rowHeight = 0;
+        }
+        atlasX[c] = penX;
+        atlasY[c] = penY;
+        penX += width + TEXT_ATLAS_PADDING;
+        rowHeight = std::max(rowHeight, rows);
 
         Character character = {
-            texture,
-            {static_cast<int>(face->glyph->bitmap.width), static_cast<int>(face->glyph->bitmap.rows)},
+            0,
+            {width, rows},
             {face->glyph->bitmap_left, face->glyph->bitmap_top},
-            static_cast<unsigned int>(face->glyph->advance.x)
+            static_cast<unsigned int>(face->glyph->advance.x),
+            {0.0f, 0.0f, 0.0f, 0.0f}
         };
         Characters.insert(std::pair<char, Character>(c, character));
     }
-    glBindTexture(GL_TEXTURE_2D, 0);
+    int atlasHeight = penY + rowHeight;
 
     FT_Done_Face(face);
     FT_Done_FreeType(ft);
 
+    // 2. one texture for all of them
+    glGenTextures(1, &atlasTexture);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    std::vector<unsigned char> cleared((size_t)TEXT_ATLAS_WIDTH * atlasHeight, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, TEXT_ATLAS_WIDTH, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, cleared.data());
+    for (auto& entry : Characters)
+    {
+        unsigned char c = (unsigned char)entry.first;
+        Character& ch = entry.second;
+        if (!bitmaps[c].empty())
+            glTexSubImage2D(GL_TEXTURE_2D, 0, atlasX[c], atlasY[c], ch.Size[0], ch.Size[1], GL_RED, GL_UNSIGNED_BYTE, bitmaps[c].data());
+        ch.TextureID = atlasTexture;
+        ch.Uv[0] = (float)atlasX[c] / TEXT_ATLAS_WIDTH;
+        ch.Uv[1] = (float)atlasY[c] / atlasHeight;
+        ch.Uv[2] = (float)(atlasX[c] + ch.Size[0]) / TEXT_ATLAS_WIDTH;
+        ch.Uv[3] = (float)(atlasY[c] + ch.Size[1]) / atlasHeight;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // coverage reads as alpha of a white texel
+    const GLint swizzle[4] = { GL_ONE, GL_ONE, GL_ONE, GL_RED };
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    trackResource(ResourceKind::Texture, atlasTexture, estimateTextureBytes(TEXT_ATLAS_WIDTH, atlasHeight, 1, false), "Text", fontPath);
+
     glGenVertexArrays(1, &textVAO);
     glGenBuffers(1, &textVBO);
     glBindVertexArray(textVAO);
     glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+    trackResource(ResourceKind::VertexArray, textVAO, 0, "Text");
+    trackResource(ResourceKind::Buffer, textVBO, 0, "Text");
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 }
 
-void RenderText(unsigned int shader, std::string text, float x, float y, float scale, float r, float g, float b)
+void releaseText()
 {
-    glUseProgram(shader);
-    glUniform3f(glGetUniformLocation(shader, "textColor"), r, g, b);
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(textVAO);
+    if (!atlasTexture) return;
+    glDeleteTextures(1, &atlasTexture);
+    glDeleteVertexArrays(1, &textVAO);
+    glDeleteBuffers(1, &textVBO);
+    untrackResource(ResourceKind::Texture, atlasTexture);
+    untrackResource(ResourceKind::VertexArray, textVAO);
+    untrackResource(ResourceKind::Buffer, textVBO);
+    atlasTexture = 0;
+    Characters.clear();
+}
 
-    std::string::const_iterator c;
-    for (c = text.begin(); c != text.end(); c++)
+unsigned int textAtlas()
+{
+    return atlasTexture;
+}
+
+float layoutText(const std::string& text, float x, float y, float scale, std::vector<GlyphQuad>& quads)
+{
+    for (char c : text)
     {
-        Character ch = Characters[*c];
+        std::map<char, Character>::const_iterator found = Characters.find(c);
+        if (found == Characters.end()) continue;
+        const Character& ch = found->second;
 
         float xpos = x + ch.Bearing[0] * scale;
         float ypos = y - (ch.Size[1] - ch.Bearing[1]) * scale;
+        if (ch.Size[0] > 0 && ch.Size[1] > 0)
+            quads.push_back({ xpos, ypos, xpos + ch.Size[0] * scale, ypos + ch.Size[1] * scale, ch.Uv[0], ch.Uv[1], ch.Uv[2], ch.Uv[3] });
 
-        float w = ch.Size[0] * scale;
-        float h = ch.Size[1] * scale;
+        x += (ch.Advance >> 6) * scale;
+    }
+    return x;
+}
 
-        float vertices[6][4] = {
-            { xpos,     ypos + h,   0.0f, 0.0f },
-            { xpos,     ypos,       0.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
+void RenderText(unsigned int shader, std::string text, float x, float y, float scale, float r, float g, float b)
+{
+    textQuads.clear();
+    layoutText(text, x, y, scale, textQuads);
+    if (textQuads.empty()) return;
 
-            { xpos,     ypos + h,   0.0f, 0.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
-            { xpos + w, ypos + h,   1.0f, 0.0f }
+    // the atlas is top row first: a quad's top edge (y1) samples v0
+    textVertices.clear();
+    for (const GlyphQuad& q : textQuads)
+    {
+        const float vertices[6][4] = {
+            { q.x0, q.y1, q.u0, q.v0 },
+            { q.x0, q.y0, q.u0, q.v1 },
+            { q.x1, q.y0, q.u1, q.v1 },
+
+            { q.x0, q.y1, q.u0, q.v0 },
+            { q.x1, q.y0, q.u1, q.v1 },
+            { q.x1, q.y1, q.u1, q.v0 }
         };
+        textVertices.insert(textVertices.end(), &vertices[0][0], &vertices[0][0] + 24);
+    }
 
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glUseProgram(shader);
+    glUniform3f(glGetUniformLocation(shader, "textColor"), r, g, b);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glBindVertexArray(textVAO);
 
-        x += (ch.Advance >> 6) * scale;
+    // orphaned every call: the driver hands out fresh storage instead of waiting on the last draw
+    size_t bytes = textVertices.size() * sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
+    glBufferData(GL_ARRAY_BUFFER, bytes, textVertices.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (bytes != textVBOBytes)
+    {
+        textVBOBytes = bytes;
+        trackResource(ResourceKind::Buffer, textVBO, bytes, "Text");
     }
+
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(textVertices.size() / 4));
     glBindVertexArray(0);
     glBindTexture(GL_TEXTURE_2D, 0);
-}
\ No newline at end of file
+}
@@ -1,4 +1,6 @@
 #include "../Header/Util.h";
+#include "../Header/ResourceRegistry.h"
+#include "../Header/AssetPack.h"
 
 #define _CRT_SECURE_NO_WARNINGS
 #include <fstream>
@@ -9,7 +11,7 @@
 #include "../Header/stb_image.h"
 
 // Autor: Nedeljko Tesanovic
-// Opis: pomocne funkcije za zaustavljanje programa, ucitavanje sejdera, tekstura i kursora
+// Opis: pomocne funkcije za zaustavljanje programa, ucitavanje sejdera i kursora
 // Smeju se koristiti tokom izrade projekta
 
 int endProgram(std::string message) {
@@ -97,55 +99,16 @@ unsigned int createShader(const char* vsSource, const char* fsSource)
     return program;
 }
 
-unsigned loadImageToTexture(const char* filePath) {
-    int TextureWidth;
-    int TextureHeight;
-    int TextureChannels;
-    unsigned char* ImageData = stbi_load(filePath, &TextureWidth, &TextureHeight, &TextureChannels, 0);
-    if (ImageData != NULL)
-    {
-        //Slike se osnovno ucitavaju naopako pa se moraju ispraviti da budu uspravne
-        stbi__vertical_flip(ImageData, TextureWidth, TextureHeight, TextureChannels);
-
-        // Provjerava koji je format boja ucitane slike
-        GLint InternalFormat = -1;
-        switch (TextureChannels) {
-        case 1: InternalFormat = GL_RED; break;
-        case 2: InternalFormat = GL_RG; break;
-        case 3: InternalFormat = GL_RGB; break;
-        case 4: InternalFormat = GL_RGBA; break;
-        default: InternalFormat = GL_RGB; break;
-        }
-
-        unsigned int Texture;
-        glGenTextures(1, &Texture);
-        glBindTexture(GL_TEXTURE_2D, Texture);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT); // Ponavljanje po sirini
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT); // Ponavljanje po visini
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // Filter pri smanjivanju
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        glTexImage2D(GL_TEXTURE_2D, 0, InternalFormat, TextureWidth, TextureHeight, 0, InternalFormat, GL_UNSIGNED_BYTE, ImageData);
-        glBindTexture(GL_TEXTURE_2D, 0);
-        // oslobadjanje memorije zauzete sa stbi_load posto vise nije potrebna
-        stbi_image_free(ImageData);
-        return Texture;
-    }
-    else
-    {
-        std::cout << "Textura nije ucitana! Putanja texture: " << filePath << std::endl;
-        stbi_image_free(ImageData);
-        return 0;
-    }
-}
-
 GLFWcursor* loadImageToCursor(const char* filePath) {
     int TextureWidth;
     int TextureHeight;
     int TextureChannels;
 
-    unsigned char* ImageData = stbi_load(filePath, &TextureWidth, &TextureHeight, &TextureChannels, 0);
+    // Slika se cita iz asset paketa ako postoji, inace sa diska
+    AssetView file;
+    unsigned char* ImageData = NULL;
+    if (readAsset(filePath, file))
+        ImageData = stbi_load_from_memory(file.data, (int)file.size, &TextureWidth, &TextureHeight, &TextureChannels, 0);
 
     if (ImageData != NULL)
     {